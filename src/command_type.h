@@ -329,6 +329,8 @@ enum Commands {
 
 	CMD_OPEN_CLOSE_AIRPORT,           ///< open/close an airport to incoming aircraft
 
+	CMD_POSTPONE_LINKGRAPH_JOB,       ///< postpone joining a link graph job that is not done yet
+
 	CMD_END,                          ///< Must ALWAYS be on the end of this list!! (period)
 };
 
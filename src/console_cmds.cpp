@@ -38,6 +38,10 @@
 #include "console_func.h"
 #include "engine_base.h"
 #include "game/game.hpp"
+#include "tick_profiler.h"
+#include "pathfinder/pf_replay.h"
+#include "linkgraph/linkgraphschedule.h"
+#include "cargotype.h"
 #include "table/strings.h"
 
 #include "safeguards.h"
@@ -1327,6 +1331,119 @@ DEF_CONSOLE_CMD(ConGetDate)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConTickProfile)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show how long the phases of the last game ticks took. Usage: 'tick_profile [reset]'");
+		IConsoleHelp("Times are given in milliseconds; 'reset' discards the recorded ticks.");
+		return true;
+	}
+
+	if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+		TickProfilerReset();
+		IConsolePrint(CC_DEFAULT, "Tick profile reset.");
+		return true;
+	}
+
+	if (argc != 1) return false;
+
+	TickProfilerStats stats;
+	GetTickProfilerStats(TPP_BEGIN, &stats);
+	if (stats.samples == 0) {
+		IConsolePrint(CC_WARNING, "No ticks have been recorded yet.");
+		return true;
+	}
+
+	IConsolePrintF(CC_DEFAULT, "Over the last %u ticks:", stats.samples);
+	for (TickProfilerPhase phase = TPP_BEGIN; phase < TPP_END; phase++) {
+		GetTickProfilerStats(phase, &stats);
+		IConsolePrintF(CC_DEFAULT, "  %-12s min: %7.3f  avg: %7.3f  p99: %7.3f  max: %7.3f", GetTickProfilerPhaseName(phase),
+				stats.min / 1000.0, stats.avg / 1000.0, stats.p99 / 1000.0, stats.max / 1000.0);
+	}
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConLinkGraphStats)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show how long the link graph jobs of each cargo waited and ran. Usage: 'linkgraph_stats [reset]'");
+		IConsoleHelp("'sched' is the wait in the schedule in days, 'pool' the wait for a thread and 'run' the calculation time, both in milliseconds.");
+		IConsoleHelp("'stalls' counts the joins the game waited for, with the waits in milliseconds; 'postponed' counts the joins put off because the job was not done.");
+		IConsoleHelp("'reset' discards the recorded jobs.");
+		return true;
+	}
+
+	if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+		LinkGraphSchedule::instance.ResetStats();
+		IConsolePrint(CC_DEFAULT, "Link graph statistics reset.");
+		return true;
+	}
+
+	if (argc != 1) return false;
+
+	bool any = false;
+	const CargoSpec *cs;
+	FOR_ALL_SORTED_STANDARD_CARGOSPECS(cs) {
+		const LinkGraphJobStats &stats = LinkGraphSchedule::instance.GetStats(cs->Index());
+		if (stats.spawned == 0 && stats.joined == 0) continue;
+
+		if (!any) IConsolePrint(CC_DEFAULT, "Link graph jobs per cargo:");
+		any = true;
+
+		char name[64];
+		GetString(name, cs->name, lastof(name));
+		IConsolePrintF(CC_DEFAULT, "  %-16s jobs: %4u  sched avg: %5.1f  max: %4u  pool avg: %8.3f  max: %8.3f  run avg: %8.3f  max: %8.3f", name,
+				stats.joined,
+				stats.spawned == 0 ? 0.0 : (double)stats.schedule_wait / stats.spawned, stats.max_schedule_wait,
+				stats.joined == 0 ? 0.0 : stats.pool_wait / 1000.0 / stats.joined, stats.max_pool_wait / 1000.0,
+				stats.joined == 0 ? 0.0 : stats.run_time / 1000.0 / stats.joined, stats.max_run_time / 1000.0);
+		if (stats.stalls != 0 || stats.postponed != 0) {
+			IConsolePrintF(CC_WARNING, "  %-16s stalls: %4u  total: %10.3f  max: %8.3f  postponed: %4u", "",
+					stats.stalls, stats.stall_time / 1000.0, stats.max_stall_time / 1000.0, stats.postponed);
+		}
+	}
+	if (!any) IConsolePrint(CC_WARNING, "No link graph jobs have been recorded yet.");
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConPathfinderCapture)
+{
+	if (argc == 0) {
+		IConsoleHelp("Record the pathfinder queries of the running game. Usage: 'pf_capture start <name>' or 'pf_capture stop'");
+		IConsoleHelp("'start' saves the game as <name>.sav and records the queries to <name>.pfq, for use with 'pf_replay'.");
+		return true;
+	}
+
+	if (argc == 2 && strcmp(argv[1], "stop") == 0) {
+		PathfinderCaptureStop();
+		IConsolePrint(CC_DEFAULT, "Pathfinder capture stopped.");
+		return true;
+	}
+
+	if (argc != 3 || strcmp(argv[1], "start") != 0) return false;
+
+	if (!PathfinderCaptureStart(argv[2])) {
+		IConsolePrint(CC_ERROR, "Starting the pathfinder capture failed.");
+	} else {
+		IConsolePrintF(CC_DEFAULT, "Recording pathfinder queries to %s.pfq.", argv[2]);
+	}
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConPathfinderReplay)
+{
+	if (argc == 0) {
+		IConsoleHelp("Run recorded pathfinder queries with every pathfinder. Usage: 'pf_replay <name>'");
+		IConsoleHelp("Load <name>.sav first; reports the nodes, time and a hash of the results per pathfinder.");
+		return true;
+	}
+
+	if (argc != 2) return false;
+
+	if (!PathfinderReplay(argv[1])) IConsolePrintF(CC_ERROR, "Reading %s.pfq failed.", argv[1]);
+	return true;
+}
+
 
 DEF_CONSOLE_CMD(ConAlias)
 {
@@ -1915,6 +2032,10 @@ void IConsoleStdLibRegister()
 	IConsoleCmdRegister("restart",      ConRestart);
 	IConsoleCmdRegister("getseed",      ConGetSeed);
 	IConsoleCmdRegister("getdate",      ConGetDate);
+	IConsoleCmdRegister("tick_profile", ConTickProfile);
+	IConsoleCmdRegister("linkgraph_stats", ConLinkGraphStats);
+	IConsoleCmdRegister("pf_capture",   ConPathfinderCapture);
+	IConsoleCmdRegister("pf_replay",    ConPathfinderReplay, ConHookNoNetwork);
 	IConsoleCmdRegister("quit",         ConExit);
 	IConsoleCmdRegister("resetengines", ConResetEngines, ConHookNoNetwork);
 	IConsoleCmdRegister("reset_enginepool", ConResetEnginePool, ConHookNoNetwork);
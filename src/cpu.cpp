@@ -69,11 +69,11 @@ uint64 ottd_rdtsc()
 #endif
 
 /* In all other cases we have no support for rdtsc. No major issue,
- * you just won't be able to profile your code with TIC()/TOC() */
+ * you just won't be able to use the cycle counter for timing your code */
 #if !defined(RDTSC_AVAILABLE)
 /* MSVC (in case of WinCE) can't handle #warning */
 # if !defined(_MSC_VER)
-#warning "(non-fatal) No support for rdtsc(), you won't be able to profile with TIC/TOC"
+#warning "(non-fatal) No support for rdtsc(), you won't be able to use the cycle counter"
 # endif
 uint64 ottd_rdtsc() {return 0;}
 #endif
@@ -50,6 +50,7 @@
 #include "goal_base.h"
 #include "story_base.h"
 #include "linkgraph/refresh.h"
+#include "pathfinder/yapf/yapf_cache.h"
 
 #include "table/strings.h"
 #include "table/pricebase.h"
@@ -492,6 +493,10 @@ void ChangeOwnershipOfCompanyItems(Owner old_owner, Owner new_owner)
 			ChangeTileOwner(tile, old_owner, new_owner);
 		} while (++tile != MapSize());
 
+		/* Tracks and depots may have a new owner. */
+		YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+		YapfNotifyRoadLayoutChange(INVALID_TILE);
+
 		if (new_owner != INVALID_OWNER) {
 			/* Update all signals because there can be new segment that was owned by two companies
 			 * and signals were not propagated
@@ -30,7 +30,9 @@
 #include "core/random_func.hpp"
 #include "object_base.h"
 #include "company_func.h"
+#include "station_map.h"
 #include "pathfinder/npf/aystar.h"
+#include "pathfinder/yapf/yapf_cache.h"
 #include <list>
 #include <set>
 
@@ -493,6 +495,9 @@ void DoClearSquare(TileIndex tile)
 
 	MakeClear(tile, CLEAR_GRASS, _generating_world ? 3 : 0);
 	MarkTileDirtyByTile(tile);
+	/* Whatever was here, ships might have been able to sail on it. The water
+	 * regions are not saved, so every client has to drop them at the same time. */
+	YapfNotifyWaterLayoutChange(tile);
 }
 
 /**
@@ -714,6 +719,44 @@ CommandCost CmdClearArea(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 
 TileIndex _cur_tileloop_tile;
 
+/**
+ * Get the tile types of which the tile loop does nothing in the current game.
+ * Skipping these tiles does not change the game state nor the sequence of random numbers.
+ * @return Bitmask of the tile types that do not need the tile loop.
+ */
+static uint GetTileTypesWithoutTileLoop()
+{
+	uint types = 1 << MP_VOID;
+	/* Tunnels and bridges only get snow or desert in those climates. */
+	if (_settings_game.game_creation.landscape != LT_ARCTIC && _settings_game.game_creation.landscape != LT_TROPIC) SetBit(types, MP_TUNNELBRIDGE);
+	return types;
+}
+
+/**
+ * Check whether the tile loop of a tile might change anything.
+ * @param tile The tile to check.
+ * @param skip_types The tile types that do not need the tile loop, see #GetTileTypesWithoutTileLoop.
+ * @return False if calling the tile loop of the tile is known to do nothing.
+ */
+static inline bool NeedsTileLoop(TileIndex tile, uint skip_types)
+{
+	TileType type = GetTileType(tile);
+	if (HasBit(skip_types, type)) return false;
+	if (type != MP_STATION) return true;
+
+	/* Only airports, docks, buoys and oil rigs do something in their tile loop. */
+	switch (GetStationType(tile)) {
+		case STATION_RAIL:
+		case STATION_TRUCK:
+		case STATION_BUS:
+		case STATION_WAYPOINT:
+			return false;
+
+		default:
+			return true;
+	}
+}
+
 /**
  * Gradually iterate over all tiles on the map, calling their TileLoopProcs once every 256 ticks.
  */
@@ -738,14 +781,20 @@ void RunTileLoop()
 	/* The LFSR cannot have a zeroed state. */
 	assert(tile != 0);
 
+	/* Tiles of which the tile loop does nothing are skipped; they still take
+	 * their turn in the sequence, so all other tiles are looped at the same time.
+	 * The tile loop of nearly all other tiles draws random numbers, so they
+	 * cannot be skipped and their tile type has to be read anyway. */
+	uint skip_types = GetTileTypesWithoutTileLoop();
+
 	/* Manually update tile 0 every 256 ticks - the LFSR never iterates over it itself.  */
 	if (_tick_counter % 256 == 0) {
-		_tile_type_procs[GetTileType(0)]->tile_loop_proc(0);
+		if (NeedsTileLoop(0, skip_types)) _tile_type_procs[GetTileType(0)]->tile_loop_proc(0);
 		count--;
 	}
 
 	while (count--) {
-		_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
+		if (NeedsTileLoop(tile, skip_types)) _tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
 
 		/* Get the next tile in sequence using a Galois LFSR. */
 		tile = (tile >> 1) ^ (-(int32)(tile & 1) & feedback);
@@ -1074,37 +1123,29 @@ static uint River_Hash(uint tile, uint dir)
 
 /**
  * Actually build the river between the begin and end tiles using AyStar.
+ * @param finder The river finder; it is cleared again after the search, keeping its memory for the next river.
  * @param begin The begin of the river.
  * @param end The end of the river.
  */
-static void BuildRiver(TileIndex begin, TileIndex end)
+static void BuildRiver(AyStar *finder, TileIndex begin, TileIndex end)
 {
-	AyStar finder;
-	MemSetT(&finder, 0);
-	finder.CalculateG = River_CalculateG;
-	finder.CalculateH = River_CalculateH;
-	finder.GetNeighbours = River_GetNeighbours;
-	finder.EndNodeCheck = River_EndNodeCheck;
-	finder.FoundEndNode = River_FoundEndNode;
-	finder.user_target = &end;
-
-	finder.Init(River_Hash, 1 << RIVER_HASH_SIZE);
+	finder->user_target = &end;
 
 	AyStarNode start;
 	start.tile = begin;
 	start.direction = INVALID_TRACKDIR;
-	finder.AddStartNode(&start, 0);
-	finder.Main();
-	finder.Free();
+	finder->AddStartNode(&start, 0);
+	finder->Main();
 }
 
 /**
  * Try to flow the river down from a given begin.
+ * @param finder The river finder.
  * @param spring The springing point of the river.
  * @param begin  The begin point we are looking from; somewhere down hill from the spring.
  * @return True iff a river could/has been built, otherwise false.
  */
-static bool FlowRiver(TileIndex spring, TileIndex begin)
+static bool FlowRiver(AyStar *finder, TileIndex spring, TileIndex begin)
 {
 	#define SET_MARK(x) marks.insert(x)
 	#define IS_MARKED(x) (marks.find(x) != marks.end())
@@ -1144,7 +1185,7 @@ static bool FlowRiver(TileIndex spring, TileIndex begin)
 
 	if (found) {
 		/* Flow further down hill. */
-		found = FlowRiver(spring, end);
+		found = FlowRiver(finder, spring, end);
 	} else if (count > 32) {
 		/* Maybe we can make a lake. Find the Nth of the considered tiles. */
 		TileIndex lakeCenter = 0;
@@ -1176,7 +1217,7 @@ static bool FlowRiver(TileIndex spring, TileIndex begin)
 	}
 
 	marks.clear();
-	if (found) BuildRiver(begin, end);
+	if (found) BuildRiver(finder, begin, end);
 	return found;
 }
 
@@ -1191,14 +1232,25 @@ static void CreateRivers()
 	uint wells = ScaleByMapSize(4 << _settings_game.game_creation.amount_of_rivers);
 	SetGeneratingWorldProgress(GWP_RIVER, wells + 256 / 64); // Include the tile loop calls below.
 
+	/* One finder for all rivers, so the node memory of the previous river is used again. */
+	AyStar finder;
+	MemSetT(&finder, 0);
+	finder.CalculateG = River_CalculateG;
+	finder.CalculateH = River_CalculateH;
+	finder.GetNeighbours = River_GetNeighbours;
+	finder.EndNodeCheck = River_EndNodeCheck;
+	finder.FoundEndNode = River_FoundEndNode;
+	finder.Init(River_Hash, 1 << RIVER_HASH_SIZE);
+
 	for (; wells != 0; wells--) {
 		IncreaseGeneratingWorldProgress(GWP_RIVER);
 		for (int tries = 0; tries < 128; tries++) {
 			TileIndex t = RandomTile();
 			if (!CircularTileSearch(&t, 8, FindSpring, NULL)) continue;
-			if (FlowRiver(t, t)) break;
+			if (FlowRiver(&finder, t, t)) break;
 		}
 	}
+	finder.Free();
 
 	/* Run tile loop to update the ground density. */
 	for (uint i = 0; i != 256; i++) {
@@ -2,18 +2,95 @@
 
 #include "../stdafx.h"
 #include "demands.h"
-#include <list>
+#include "../core/alloc_type.hpp"
+#include <vector>
 
 #include "../safeguards.h"
 
-typedef std::list<NodeID> NodeList;
+/**
+ * Queue of node IDs. Every node is at most once in the queue, so a ring
+ * buffer with one slot per node never overflows.
+ */
+class NodeQueue {
+public:
+	/**
+	 * Create an empty queue.
+	 * @param size Number of nodes in the link graph.
+	 */
+	NodeQueue(uint size) : ids(max(size, 1U)), first(0), count(0) {}
+
+	/**
+	 * Check if the queue is empty.
+	 * @return True if there are no nodes in the queue.
+	 */
+	inline bool IsEmpty() const { return this->count == 0; }
+
+	/**
+	 * Append a node to the queue.
+	 * @param id Node to append.
+	 */
+	inline void PushBack(NodeID id)
+	{
+		assert(this->count < this->ids.size());
+		uint last = this->first + this->count++;
+		if (last >= this->ids.size()) last -= this->ids.size();
+		this->ids[last] = id;
+	}
+
+	/**
+	 * Remove the first node from the queue.
+	 * @return The node.
+	 */
+	inline NodeID PopFront()
+	{
+		assert(!this->IsEmpty());
+		NodeID id = this->ids[this->first];
+		if (++this->first == this->ids.size()) this->first = 0;
+		this->count--;
+		return id;
+	}
+
+private:
+	std::vector<NodeID> ids; ///< Slots of the ring buffer.
+	uint first;              ///< Slot of the first node.
+	uint count;              ///< Number of nodes in the queue.
+};
+
+/**
+ * The node data the demand calculation uses in each step, in arrays indexed
+ * by node ID, so that the calculations for many pairs of nodes run in tight
+ * loops without going through the link graph job.
+ */
+struct DemandNodes {
+	std::vector<uint> x;           ///< X coordinate of each node.
+	std::vector<uint> y;           ///< Y coordinate of each node.
+	std::vector<uint> supply;      ///< Supply of each node.
+	std::vector<uint> undelivered; ///< Supply of each node that hasn't been distributed yet.
+	std::vector<byte> accepts;     ///< Whether each node accepts the cargo.
+
+	/**
+	 * Copy the data of all nodes of a job.
+	 * @param job Job to copy the data from.
+	 */
+	DemandNodes(LinkGraphJob &job) : x(job.Size()), y(job.Size()), supply(job.Size()),
+			undelivered(job.Size()), accepts(job.Size())
+	{
+		for (NodeID node = 0; node < job.Size(); node++) {
+			this->x[node] = TileX(job[node].XY());
+			this->y[node] = TileY(job[node].XY());
+			this->supply[node] = job[node].Supply();
+			this->undelivered[node] = job[node].UndeliveredSupply();
+			this->accepts[node] = job[node].Demand() > 0;
+		}
+	}
+};
 
 /**
  * Scale various things according to symmetric/asymmetric distribution.
  */
 class Scaler {
 public:
-	void SetDemands(LinkGraphJob &job, NodeID from, NodeID to, uint demand_forw);
+	void SetDemands(LinkGraphJob &job, DemandNodes &nodes, NodeID from, NodeID to, uint demand_forw);
 };
 
 /**
@@ -51,28 +128,29 @@ public:
 	/**
 	 * Get the effective supply of one node towards another one. In symmetric
 	 * distribution the supply of the other node is weighed in.
-	 * @param from The supplying node.
-	 * @param to The receiving node.
+	 * @param from_supply Supply of the supplying node.
+	 * @param to_supply Supply of the receiving node.
 	 * @return Effective supply.
 	 */
-	inline uint EffectiveSupply(const Node &from, const Node &to)
+	inline uint EffectiveSupply(uint from_supply, uint to_supply) const
 	{
-		return max(from.Supply() * max(1U, to.Supply()) * this->mod_size / 100 / this->demand_per_node, 1U);
+		return max(from_supply * max(1U, to_supply) * this->mod_size / 100 / this->demand_per_node, 1U);
 	}
 
 	/**
 	 * Check if there is any acceptance left for this node. In symmetric distribution
 	 * nodes only accept anything if they also supply something. So if
 	 * undelivered_supply == 0 at the node there isn't any demand left either.
+	 * @param nodes Node data of the job.
 	 * @param to Node to be checked.
 	 * @return If demand is left.
 	 */
-	inline bool HasDemandLeft(const Node &to)
+	inline bool HasDemandLeft(const DemandNodes &nodes, NodeID to) const
 	{
-		return (to.Supply() == 0 || to.UndeliveredSupply() > 0) && to.Demand() > 0;
+		return (nodes.supply[to] == 0 || nodes.undelivered[to] > 0) && nodes.accepts[to];
 	}
 
-	void SetDemands(LinkGraphJob &job, NodeID from, NodeID to, uint demand_forw);
+	void SetDemands(LinkGraphJob &job, DemandNodes &nodes, NodeID from, NodeID to, uint demand_forw);
 
 private:
 	uint mod_size;        ///< Size modifier. Determines how much demands increase with the supply of the remote station.
@@ -103,59 +181,96 @@ public:
 
 	/**
 	 * Get the effective supply of one node towards another one.
-	 * @param from The supplying node.
+	 * @param from_supply Supply of the supplying node.
 	 * @param unused.
 	 */
-	inline uint EffectiveSupply(const Node &from, const Node &)
+	inline uint EffectiveSupply(uint from_supply, uint) const
 	{
-		return from.Supply();
+		return from_supply;
 	}
 
 	/**
 	 * Check if there is any acceptance left for this node. In asymmetric distribution
 	 * nodes always accept as long as their demand > 0.
+	 * @param nodes Node data of the job.
 	 * @param to The node to be checked.
-	 * @param to_anno Unused.
 	 */
-	inline bool HasDemandLeft(const Node &to) { return to.Demand() > 0; }
+	inline bool HasDemandLeft(const DemandNodes &nodes, NodeID to) const { return nodes.accepts[to]; }
 };
 
 /**
  * Set the demands between two nodes using the given base demand. In symmetric mode
  * this sets demands in both directions.
  * @param job The link graph job.
+ * @param nodes Node data of the job.
  * @param from_id The supplying node.
  * @param to_id The receiving node.
  * @param demand_forw Demand calculated for the "forward" direction.
  */
-void SymmetricScaler::SetDemands(LinkGraphJob &job, NodeID from_id, NodeID to_id, uint demand_forw)
+void SymmetricScaler::SetDemands(LinkGraphJob &job, DemandNodes &nodes, NodeID from_id, NodeID to_id, uint demand_forw)
 {
-	if (job[from_id].Demand() > 0) {
+	if (nodes.accepts[from_id]) {
 		uint demand_back = demand_forw * this->mod_size / 100;
-		uint undelivered = job[to_id].UndeliveredSupply();
+		uint undelivered = nodes.undelivered[to_id];
 		if (demand_back > undelivered) {
 			demand_back = undelivered;
 			demand_forw = max(1U, demand_back * 100 / this->mod_size);
 		}
-		this->Scaler::SetDemands(job, to_id, from_id, demand_back);
+		this->Scaler::SetDemands(job, nodes, to_id, from_id, demand_back);
 	}
 
-	this->Scaler::SetDemands(job, from_id, to_id, demand_forw);
+	this->Scaler::SetDemands(job, nodes, from_id, to_id, demand_forw);
 }
 
 /**
  * Set the demands between two nodes using the given base demand. In asymmetric mode
  * this only sets demand in the "forward" direction.
  * @param job The link graph job.
+ * @param nodes Node data of the job.
  * @param from_id The supplying node.
  * @param to_id The receiving node.
  * @param demand_forw Demand calculated for the "forward" direction.
  */
-inline void Scaler::SetDemands(LinkGraphJob &job, NodeID from_id, NodeID to_id, uint demand_forw)
+inline void Scaler::SetDemands(LinkGraphJob &job, DemandNodes &nodes, NodeID from_id, NodeID to_id, uint demand_forw)
 {
+	nodes.undelivered[from_id] -= demand_forw;
 	job[from_id].DeliverSupply(to_id, demand_forw);
 }
 
+/**
+ * Calculate the base demand from one node to another. The base demand is the
+ * effective supply scaled down by distance and accuracy, or 0 if the pair is
+ * too small or too far away to be considered at first. It doesn't change
+ * between rounds of the calculation.
+ * @param nodes Node data of the job.
+ * @param scaler Scaler to be used for scaling demands.
+ * @param from_id The supplying node.
+ * @param to_id The receiving node.
+ * @return Base demand from \a from_id to \a to_id.
+ * @tparam Tscaler Scaler to be used for scaling demands.
+ */
+template<class Tscaler>
+inline uint DemandCalculator::CalcBaseDemand(const DemandNodes &nodes, const Tscaler &scaler, NodeID from_id, NodeID to_id) const
+{
+	int32 supply = scaler.EffectiveSupply(nodes.supply[from_id], nodes.supply[to_id]);
+
+	/* Same as DistanceMaxPlusManhattan. */
+	uint dx = Delta(nodes.x[from_id], nodes.x[to_id]);
+	uint dy = Delta(nodes.y[from_id], nodes.y[to_id]);
+	int32 manhattan = (int32)(dx > dy ? 2 * dx + dy : 2 * dy + dx);
+
+	/* Scale the distance by mod_dist around max_distance */
+	int32 distance = this->max_distance - (this->max_distance - manhattan) * this->mod_dist / 100;
+
+	/* Scale the accuracy by distance around accuracy / 2 */
+	int32 divisor = this->accuracy * (this->mod_dist - 50) / 100 + this->accuracy * distance / this->max_distance + 1;
+
+	/* At first only distribute demand if
+	 * effective supply / accuracy divisor >= 1
+	 * Others are too small or too far away to be considered. */
+	return divisor <= supply ? supply / divisor : 0;
+}
+
 /**
  * Do the actual demand calculation, called from constructor.
  * @param job Job to calculate the demands for.
@@ -164,19 +279,21 @@ inline void Scaler::SetDemands(LinkGraphJob &job, NodeID from_id, NodeID to_id,
 template<class Tscaler>
 void DemandCalculator::CalcDemand(LinkGraphJob &job, Tscaler scaler)
 {
-	NodeList supplies;
-	NodeList demands;
+	const uint size = job.Size();
+	DemandNodes nodes(job);
+	NodeQueue supplies(size);
+	NodeQueue demands(size);
 	uint num_supplies = 0;
 	uint num_demands = 0;
 
-	for (NodeID node = 0; node < job.Size(); node++) {
+	for (NodeID node = 0; node < size; node++) {
 		scaler.AddNode(job[node]);
-		if (job[node].Supply() > 0) {
-			supplies.push_back(node);
+		if (nodes.supply[node] > 0) {
+			supplies.PushBack(node);
 			num_supplies++;
 		}
-		if (job[node].Demand() > 0) {
-			demands.push_back(node);
+		if (nodes.accepts[node]) {
+			demands.PushBack(node);
 			num_demands++;
 		}
 	}
@@ -189,63 +306,64 @@ void DemandCalculator::CalcDemand(LinkGraphJob &job, Tscaler scaler)
 	scaler.SetDemandPerNode(num_demands);
 	uint chance = 0;
 
-	while (!supplies.empty() && !demands.empty()) {
-		NodeID from_id = supplies.front();
-		supplies.pop_front();
+	/* Keep the base demands of the pairs visited so far if they fit into the
+	 * budget; otherwise calculate them again whenever a pair is visited. Each
+	 * supplying node gets a row of base demands plus one, so that 0 marks a
+	 * pair not visited yet. Most pairs are never visited if the supply is
+	 * small, so the rows are only calculated on demand and the zeroed memory
+	 * of the untouched ones is never even mapped. */
+	bool keep = (uint64)num_supplies * size <= MAX_KEPT_BASE_DEMANDS;
+	AutoFreePtr<uint> base_demands(keep ? CallocT<uint>(num_supplies * size) : NULL);
+	std::vector<uint> rows(keep ? size : 0, UINT_MAX);
+	uint num_rows = 0;
+
+	while (!supplies.IsEmpty() && !demands.IsEmpty()) {
+		NodeID from_id = supplies.PopFront();
+
+		uint *base = NULL;
+		if (keep) {
+			if (rows[from_id] == UINT_MAX) rows[from_id] = num_rows++;
+			base = base_demands + rows[from_id] * size;
+		}
 
 		for (uint i = 0; i < num_demands; ++i) {
-			assert(!demands.empty());
-			NodeID to_id = demands.front();
-			demands.pop_front();
+			NodeID to_id = demands.PopFront();
 			if (from_id == to_id) {
 				/* Only one node with supply and demand left */
-				if (demands.empty() && supplies.empty()) return;
+				if (demands.IsEmpty() && supplies.IsEmpty()) return;
 
-				demands.push_back(to_id);
+				demands.PushBack(to_id);
 				continue;
 			}
 
-			int32 supply = scaler.EffectiveSupply(job[from_id], job[to_id]);
-			assert(supply > 0);
-
-			/* Scale the distance by mod_dist around max_distance */
-			int32 distance = this->max_distance - (this->max_distance -
-					(int32)DistanceMaxPlusManhattan(job[from_id].XY(), job[to_id].XY())) *
-					this->mod_dist / 100;
-
-			/* Scale the accuracy by distance around accuracy / 2 */
-			int32 divisor = this->accuracy * (this->mod_dist - 50) / 100 +
-					this->accuracy * distance / this->max_distance + 1;
-
-			assert(divisor > 0);
-
-			uint demand_forw = 0;
-			if (divisor <= supply) {
-				/* At first only distribute demand if
-				 * effective supply / accuracy divisor >= 1
-				 * Others are too small or too far away to be considered. */
-				demand_forw = supply / divisor;
-			} else if (++chance > this->accuracy * num_demands * num_supplies) {
+			uint demand_forw;
+			if (base == NULL) {
+				demand_forw = this->CalcBaseDemand(nodes, scaler, from_id, to_id);
+			} else {
+				if (base[to_id] == 0) base[to_id] = this->CalcBaseDemand(nodes, scaler, from_id, to_id) + 1;
+				demand_forw = base[to_id] - 1;
+			}
+			if (demand_forw == 0 && ++chance > this->accuracy * num_demands * num_supplies) {
 				/* After some trying, if there is still supply left, distribute
 				 * demand also to other nodes. */
 				demand_forw = 1;
 			}
 
-			demand_forw = min(demand_forw, job[from_id].UndeliveredSupply());
+			demand_forw = min(demand_forw, nodes.undelivered[from_id]);
 
-			scaler.SetDemands(job, from_id, to_id, demand_forw);
+			scaler.SetDemands(job, nodes, from_id, to_id, demand_forw);
 
-			if (scaler.HasDemandLeft(job[to_id])) {
-				demands.push_back(to_id);
+			if (scaler.HasDemandLeft(nodes, to_id)) {
+				demands.PushBack(to_id);
 			} else {
 				num_demands--;
 			}
 
-			if (job[from_id].UndeliveredSupply() == 0) break;
+			if (nodes.undelivered[from_id] == 0) break;
 		}
 
-		if (job[from_id].UndeliveredSupply() != 0) {
-			supplies.push_back(from_id);
+		if (nodes.undelivered[from_id] != 0) {
+			supplies.PushBack(from_id);
 		} else {
 			num_supplies--;
 		}
@@ -5,6 +5,8 @@
 
 #include "linkgraphjob_base.h"
 
+struct DemandNodes;
+
 /**
  * Calculate the demands. This class has a state, but is recreated for each
  * call to of DemandHandler::Run.
@@ -18,6 +20,12 @@ private:
 	int32 mod_dist;     ///< Distance modifier, determines how much demands decrease with distance.
 	int32 accuracy;     ///< Accuracy of the calculation.
 
+	/* Up to 16 MB of base demands are kept between the rounds of the calculation. */
+	static const uint MAX_KEPT_BASE_DEMANDS = 1 << 22; ///< Maximum number of base demands kept between rounds.
+
+	template<class Tscaler>
+	uint CalcBaseDemand(const DemandNodes &nodes, const Tscaler &scaler, NodeID from_id, NodeID to_id) const;
+
 	template<class Tscaler>
 	void CalcDemand(LinkGraphJob &job, Tscaler scaler);
 };
@@ -29,10 +37,15 @@ class DemandHandler : public ComponentHandler {
 public:
 
 	/**
-	 * Call the demand calculator on the given component.
+	 * Call the demand calculator on the given component and merge the
+	 * demands it delivered.
 	 * @param graph Component to calculate the demands for.
 	 */
-	virtual void Run(LinkGraphJob &job) const { DemandCalculator c(job); }
+	virtual void Run(LinkGraphJob &job) const
+	{
+		DemandCalculator c(job);
+		job.MergeDemands();
+	}
 
 	/**
 	 * Virtual destructor has to be defined because of virtual Run().
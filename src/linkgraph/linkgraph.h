@@ -14,11 +14,11 @@
 
 #include "../core/pool_type.hpp"
 #include "../core/smallmap_type.hpp"
-#include "../core/smallmatrix_type.hpp"
 #include "../station_base.h"
 #include "../cargotype.h"
 #include "../date_func.h"
 #include "linkgraph_type.h"
+#include <vector>
 
 struct SaveLoad;
 class LinkGraph;
@@ -55,20 +55,68 @@ public:
 	};
 
 	/**
-	 * An edge in the link graph. Corresponds to a link between two stations or at
-	 * least the distance between them. Edges from one node to itself contain the
-	 * ID of the opposite Node of the first active edge (i.e. not just distance) in
-	 * the column as next_edge.
+	 * An edge in the link graph. Corresponds to a link between two stations.
+	 * Only the edges that actually exist are stored.
 	 */
 	struct BaseEdge {
 		uint capacity;                 ///< Capacity of the link.
 		uint usage;                    ///< Usage of the link.
 		Date last_unrestricted_update; ///< When the unrestricted part of the link was last updated.
 		Date last_restricted_update;   ///< When the restricted part of the link was last updated.
-		NodeID next_edge;              ///< Destination of next valid edge starting at the same source node.
-		void Init();
+		NodeID dest;                   ///< Destination of the edge.
+		void Init(NodeID dest = INVALID_NODE);
 	};
 
+	/** Edges starting at one node, sorted by destination. */
+	typedef std::vector<BaseEdge> EdgeList;
+
+	/** Edge returned when asking for one that doesn't exist. */
+	static const BaseEdge EMPTY_EDGE;
+
+	/**
+	 * Get the position an edge has or would have in a list of edges.
+	 * @param edges Edges starting at a node.
+	 * @param to Destination of the edge.
+	 * @return Index of the first edge in \a edges not going to a node before \a to.
+	 */
+	inline static uint FindEdgeIndex(const EdgeList &edges, NodeID to)
+	{
+		uint begin = 0;
+		uint end = (uint)edges.size();
+		while (begin < end) {
+			uint middle = (begin + end) / 2;
+			if (edges[middle].dest < to) {
+				begin = middle + 1;
+			} else {
+				end = middle;
+			}
+		}
+		return begin;
+	}
+
+	/**
+	 * Find an edge in a list of edges.
+	 * @param edges Edges starting at a node.
+	 * @param to Destination of the edge.
+	 * @return The edge, or NULL if there is no edge to \a to.
+	 */
+	inline static const BaseEdge *FindEdge(const EdgeList &edges, NodeID to)
+	{
+		uint index = FindEdgeIndex(edges, to);
+		return index < edges.size() && edges[index].dest == to ? &edges[index] : NULL;
+	}
+
+	/**
+	 * Find an edge in a list of edges.
+	 * @param edges Edges starting at a node.
+	 * @param to Destination of the edge.
+	 * @return The edge, or NULL if there is no edge to \a to.
+	 */
+	inline static BaseEdge *FindEdge(EdgeList &edges, NodeID to)
+	{
+		return const_cast<BaseEdge *>(FindEdge(const_cast<const EdgeList &>(edges), to));
+	}
+
 	/**
 	 * Wrapper for an edge (const or not) allowing retrieval, but no modification.
 	 * @tparam Tedge Actual edge class, may be "const BaseEdge" or just "BaseEdge".
@@ -119,15 +167,15 @@ public:
 
 	/**
 	 * Wrapper for a node (const or not) allowing retrieval, but no modification.
-	 * @tparam Tedge Actual node class, may be "const BaseNode" or just "BaseNode".
-	 * @tparam Tedge Actual edge class, may be "const BaseEdge" or just "BaseEdge".
+	 * @tparam Tnode Actual node class, may be "const BaseNode" or just "BaseNode".
+	 * @tparam Tedges Actual edge list class, may be "const EdgeList" or just "EdgeList".
 	 */
-	template<typename Tnode, typename Tedge>
+	template<typename Tnode, typename Tedges>
 	class NodeWrapper {
 	protected:
-		Tnode &node;  ///< Node being wrapped.
-		Tedge *edges; ///< Outgoing edges for wrapped node.
-		NodeID index; ///< ID of wrapped node.
+		Tnode &node;    ///< Node being wrapped.
+		Tedges &edges;  ///< Outgoing edges for wrapped node.
+		NodeID index;   ///< ID of wrapped node.
 
 	public:
 
@@ -137,7 +185,7 @@ public:
 		 * @param edges Outgoing edges for node to be wrapped.
 		 * @param index ID of node to be wrapped.
 		 */
-		NodeWrapper(Tnode &node, Tedge *edges, NodeID index) : node(node),
+		NodeWrapper(Tnode &node, Tedges &edges, NodeID index) : node(node),
 			edges(edges), index(index) {}
 
 		/**
@@ -172,17 +220,17 @@ public:
 	};
 
 	/**
-	 * Base class for iterating across outgoing edges of a node. Only the real
-	 * edges (those with capacity) are iterated. The ones with only distance
-	 * information are skipped.
-	 * @tparam Tedge Actual edge class. May be "BaseEdge" or "const BaseEdge".
+	 * Base class for iterating across outgoing edges of a node, in the order
+	 * of their destinations. The iterator becomes invalid when edges are
+	 * added to or removed from the node.
+	 * @tparam Tedges Actual edge list class. May be "EdgeList" or "const EdgeList".
 	 * @tparam Titer Actual iterator class.
 	 */
-	template <class Tedge, class Tedge_wrapper, class Titer>
+	template <class Tedges, class Tedge_wrapper, class Titer>
 	class BaseEdgeIterator {
 	protected:
-		Tedge *base;    ///< Array of edges being iterated.
-		NodeID current; ///< Current offset in edges array.
+		Tedges *base; ///< List of edges being iterated.
+		uint current; ///< Index of the current edge in the list.
 
 		/**
 		 * A "fake" pointer to enable operator-> on temporaries. As the objects
@@ -209,12 +257,12 @@ public:
 	public:
 		/**
 		 * Constructor.
-		 * @param base Array of edges to be iterated.
-		 * @param current ID of current node (to locate the first edge).
+		 * @param base List of edges to be iterated.
+		 * @param current Index of the first edge to be iterated.
 		 */
-		BaseEdgeIterator (Tedge *base, NodeID current) :
+		BaseEdgeIterator (Tedges *base, uint current) :
 			base(base),
-			current(current == INVALID_NODE ? current : base[current].next_edge)
+			current(current)
 		{}
 
 		/**
@@ -223,7 +271,7 @@ public:
 		 */
 		Titer &operator++()
 		{
-			this->current = this->base[this->current].next_edge;
+			this->current++;
 			return static_cast<Titer &>(*this);
 		}
 
@@ -234,7 +282,7 @@ public:
 		Titer operator++(int)
 		{
 			Titer ret(static_cast<Titer &>(*this));
-			this->current = this->base[this->current].next_edge;
+			static_cast<Titer &>(*this).operator++();
 			return ret;
 		}
 
@@ -243,7 +291,7 @@ public:
 		 * child class.
 		 * @tparam Tother Class of other iterator.
 		 * @param other Instance of other iterator.
-		 * @return If the iterators have the same edge array and current node.
+		 * @return If the iterators have the same edge array and current edge.
 		 */
 		template<class Tother>
 		bool operator==(const Tother &other)
@@ -256,7 +304,7 @@ public:
 		 * may be of a child class.
 		 * @tparam Tother Class of other iterator.
 		 * @param other Instance of other iterator.
-		 * @return If either the edge arrays or the current nodes differ.
+		 * @return If either the edge arrays or the current edges differ.
 		 */
 		template<class Tother>
 		bool operator!=(const Tother &other)
@@ -270,7 +318,7 @@ public:
 		 */
 		SmallPair<NodeID, Tedge_wrapper> operator*() const
 		{
-			return SmallPair<NodeID, Tedge_wrapper>(this->current, Tedge_wrapper(this->base[this->current]));
+			return SmallPair<NodeID, Tedge_wrapper>((*this->base)[this->current].dest, Tedge_wrapper((*this->base)[this->current]));
 		}
 
 		/**
@@ -306,37 +354,37 @@ public:
 	 * An iterator for const edges. Cannot be typedef'ed because of
 	 * template-reference to ConstEdgeIterator itself.
 	 */
-	class ConstEdgeIterator : public BaseEdgeIterator<const BaseEdge, ConstEdge, ConstEdgeIterator> {
+	class ConstEdgeIterator : public BaseEdgeIterator<const EdgeList, ConstEdge, ConstEdgeIterator> {
 	public:
 		/**
 		 * Constructor.
-		 * @param edges Array of edges to be iterated over.
-		 * @param current ID of current edge's end node.
+		 * @param edges List of edges to be iterated over.
+		 * @param current Index of the current edge.
 		 */
-		ConstEdgeIterator(const BaseEdge *edges, NodeID current) :
-			BaseEdgeIterator<const BaseEdge, ConstEdge, ConstEdgeIterator>(edges, current) {}
+		ConstEdgeIterator(const EdgeList *edges, uint current) :
+			BaseEdgeIterator<const EdgeList, ConstEdge, ConstEdgeIterator>(edges, current) {}
 	};
 
 	/**
 	 * An iterator for non-const edges. Cannot be typedef'ed because of
 	 * template-reference to EdgeIterator itself.
 	 */
-	class EdgeIterator : public BaseEdgeIterator<BaseEdge, Edge, EdgeIterator> {
+	class EdgeIterator : public BaseEdgeIterator<EdgeList, Edge, EdgeIterator> {
 	public:
 		/**
 		 * Constructor.
-		 * @param edges Array of edges to be iterated over.
-		 * @param current ID of current edge's end node.
+		 * @param edges List of edges to be iterated over.
+		 * @param current Index of the current edge.
 		 */
-		EdgeIterator(BaseEdge *edges, NodeID current) :
-			BaseEdgeIterator<BaseEdge, Edge, EdgeIterator>(edges, current) {}
+		EdgeIterator(EdgeList *edges, uint current) :
+			BaseEdgeIterator<EdgeList, Edge, EdgeIterator>(edges, current) {}
 	};
 
 	/**
 	 * Constant node class. Only retrieval operations are allowed on both the
 	 * node itself and its edges.
 	 */
-	class ConstNode : public NodeWrapper<const BaseNode, const BaseEdge> {
+	class ConstNode : public NodeWrapper<const BaseNode, const EdgeList> {
 	public:
 		/**
 		 * Constructor.
@@ -344,34 +392,39 @@ public:
 		 * @param node ID of the node.
 		 */
 		ConstNode(const LinkGraph *lg, NodeID node) :
-			NodeWrapper<const BaseNode, const BaseEdge>(lg->nodes[node], lg->edges[node], node)
+			NodeWrapper<const BaseNode, const EdgeList>(lg->nodes[node], lg->edges[node], node)
 		{}
 
 		/**
 		 * Get a ConstEdge. This is not a reference as the wrapper objects are
-		 * not actually persistent.
+		 * not actually persistent. If there is no such edge an empty one is
+		 * returned.
 		 * @param to ID of end node of edge.
 		 * @return Constant edge wrapper.
 		 */
-		ConstEdge operator[](NodeID to) const { return ConstEdge(this->edges[to]); }
+		ConstEdge operator[](NodeID to) const
+		{
+			const BaseEdge *edge = LinkGraph::FindEdge(this->edges, to);
+			return ConstEdge(edge != NULL ? *edge : EMPTY_EDGE);
+		}
 
 		/**
 		 * Get an iterator pointing to the start of the edges array.
 		 * @return Constant edge iterator.
 		 */
-		ConstEdgeIterator Begin() const { return ConstEdgeIterator(this->edges, this->index); }
+		ConstEdgeIterator Begin() const { return ConstEdgeIterator(&this->edges, 0); }
 
 		/**
 		 * Get an iterator pointing beyond the end of the edges array.
 		 * @return Constant edge iterator.
 		 */
-		ConstEdgeIterator End() const { return ConstEdgeIterator(this->edges, INVALID_NODE); }
+		ConstEdgeIterator End() const { return ConstEdgeIterator(&this->edges, (uint)this->edges.size()); }
 	};
 
 	/**
 	 * Updatable node class. The node itself as well as its edges can be modified.
 	 */
-	class Node : public NodeWrapper<BaseNode, BaseEdge> {
+	class Node : public NodeWrapper<BaseNode, EdgeList> {
 	public:
 		/**
 		 * Constructor.
@@ -379,28 +432,35 @@ public:
 		 * @param node ID of the node.
 		 */
 		Node(LinkGraph *lg, NodeID node) :
-			NodeWrapper<BaseNode, BaseEdge>(lg->nodes[node], lg->edges[node], node)
+			NodeWrapper<BaseNode, EdgeList>(lg->nodes[node], lg->edges[node], node)
 		{}
 
 		/**
 		 * Get an Edge. This is not a reference as the wrapper objects are not
-		 * actually persistent.
+		 * actually persistent. The wrapper becomes invalid when edges are
+		 * added to or removed from the node. The edge has to exist. Use a
+		 * ConstNode to look up edges that may not exist.
 		 * @param to ID of end node of edge.
 		 * @return Edge wrapper.
 		 */
-		Edge operator[](NodeID to) { return Edge(this->edges[to]); }
+		Edge operator[](NodeID to)
+		{
+			BaseEdge *edge = LinkGraph::FindEdge(this->edges, to);
+			assert(edge != NULL);
+			return Edge(*edge);
+		}
 
 		/**
 		 * Get an iterator pointing to the start of the edges array.
 		 * @return Edge iterator.
 		 */
-		EdgeIterator Begin() { return EdgeIterator(this->edges, this->index); }
+		EdgeIterator Begin() { return EdgeIterator(&this->edges, 0); }
 
 		/**
 		 * Get an iterator pointing beyond the end of the edges array.
 		 * @return Constant edge iterator.
 		 */
-		EdgeIterator End() { return EdgeIterator(this->edges, INVALID_NODE); }
+		EdgeIterator End() { return EdgeIterator(&this->edges, (uint)this->edges.size()); }
 
 		/**
 		 * Update the node's supply and set last_update to the current date.
@@ -436,7 +496,7 @@ public:
 	};
 
 	typedef SmallVector<BaseNode, 16> NodeVector;
-	typedef SmallMatrix<BaseEdge> EdgeMatrix;
+	typedef std::vector<EdgeList> EdgeListVector;
 
 	/** Minimum effective distance for timeout calculation. */
 	static const uint MIN_TIMEOUT_DISTANCE = 32;
@@ -526,14 +586,16 @@ public:
 protected:
 	friend class LinkGraph::ConstNode;
 	friend class LinkGraph::Node;
+	friend class LinkGraphJob;
 	friend const SaveLoad *GetLinkGraphDesc();
 	friend const SaveLoad *GetLinkGraphJobDesc();
-	friend void SaveLoad_LinkGraph(LinkGraph &lg);
+	friend void Save_LinkGraph(LinkGraph &lg);
+	friend void Load_LinkGraph(LinkGraph &lg);
 
 	CargoID cargo;         ///< Cargo of this component's link graph.
 	Date last_compression; ///< Last time the capacities and supplies were compressed.
 	NodeVector nodes;      ///< Nodes in the component.
-	EdgeMatrix edges;      ///< Edges in the component.
+	EdgeListVector edges;  ///< Edges starting at each node in the component.
 };
 
 #define FOR_ALL_LINK_GRAPHS(var) FOR_ALL_ITEMS_FROM(LinkGraph, link_graph_index, var, 0)
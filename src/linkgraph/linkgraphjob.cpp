@@ -12,6 +12,9 @@
 #include "../stdafx.h"
 #include "../core/pool_func.hpp"
 #include "../window_func.h"
+#include "../thread/worker_pool.h"
+#include "../tick_profiler.h"
+#include "../core/sort_func.hpp"
 #include "linkgraphjob.h"
 #include "linkgraphschedule.h"
 
@@ -28,6 +31,8 @@ INSTANTIATE_POOL_METHODS(LinkGraphJob)
  */
 /* static */ Path *Path::invalid_path = new Path(INVALID_NODE, true);
 
+/* static */ const LinkGraphJob::EdgeAnnotation LinkGraphJob::EMPTY_ANNOTATION = { INVALID_NODE, 0, 0, 0 };
+
 /**
  * Create a link graph job from a link graph. The link graph will be copied so
  * that the calculations don't interfer with the normal operations on the
@@ -39,7 +44,11 @@ LinkGraphJob::LinkGraphJob(const LinkGraph &orig) :
 		 * This is on purpose. */
 		link_graph(orig),
 		settings(_settings_game.linkgraph),
-		thread(NULL),
+		batch(NULL),
+		workers(NULL),
+		post_time(0),
+		start_time(0),
+		end_time(0),
 		join_date(_date + _settings_game.linkgraph.recalc_time)
 {
 }
@@ -56,13 +65,16 @@ void LinkGraphJob::EraseFlows(NodeID from)
 }
 
 /**
- * Spawn a thread if possible and run the link graph job in the thread. If
- * that's not possible run the job right now in the current thread.
+ * Queue the link graph job in the pool of link graph threads. If the pool
+ * has no threads run the job right now in the current thread.
  */
 void LinkGraphJob::SpawnThread()
 {
-	if (!ThreadObject::New(&(LinkGraphSchedule::Run), this, &this->thread)) {
-		this->thread = NULL;
+	/* The pool is created lazily, which must not happen in the job's thread. */
+	this->workers = LinkGraphSchedule::GetWorkers();
+	this->post_time = GetProfilerTime();
+	this->batch = this->workers->Post(&LinkGraphSchedule::Run, this, 1, 1);
+	if (this->workers->GetWorkerCount() == 0) {
 		/* Of course this will hang a bit.
 		 * On the other hand, if you want to play games which make this hang noticably
 		 * on a platform without threads then you'll probably get other problems first.
@@ -70,22 +82,32 @@ void LinkGraphJob::SpawnThread()
 		 * If someone comes and tells me that this hangs for him/her, I'll implement a
 		 * smaller grained "Step" method for all handlers and add some more ticks where
 		 * "Step" is called. No problem in principle. */
-		LinkGraphSchedule::Run(this);
+		this->JoinThread();
 	}
 }
 
 /**
- * Join the calling thread with this job's thread if threading is enabled.
+ * Wait until the job is done. If no thread of the pool picked it up yet, it
+ * is run in the calling thread.
  */
 void LinkGraphJob::JoinThread()
 {
-	if (this->thread != NULL) {
-		this->thread->Join();
-		delete this->thread;
-		this->thread = NULL;
+	if (this->batch != NULL) {
+		this->workers->Wait(this->batch);
+		this->batch = NULL;
 	}
 }
 
+/**
+ * Check without blocking whether the calculation of the job is done, so
+ * joining it does not stall the game. This differs between clients.
+ * @return True if the job can be joined right away.
+ */
+bool LinkGraphJob::IsJobCompleted() const
+{
+	return this->batch == NULL || this->batch->IsDone();
+}
+
 /**
  * Join the link graph job and destroy it.
  */
@@ -119,7 +141,7 @@ LinkGraphJob::~LinkGraphJob()
 			continue;
 		}
 
-		LinkGraph *lg = LinkGraph::Get(ge.link_graph);
+		const LinkGraph *lg = LinkGraph::Get(ge.link_graph);
 		FlowStatMap &flows = from.Flows();
 
 		for (EdgeIterator it(from.Begin()); it != from.End(); ++it) {
@@ -180,21 +202,85 @@ void LinkGraphJob::Init()
 {
 	uint size = this->Size();
 	this->nodes.Resize(size);
-	this->edges.Resize(size, size);
+	this->edges.resize(size);
 	for (uint i = 0; i < size; ++i) {
 		this->nodes[i].Init(this->link_graph[i].Supply());
-		EdgeAnnotation *node_edges = this->edges[i];
-		for (uint j = 0; j < size; ++j) {
-			node_edges[j].Init();
+
+		/* Every link gets an annotation in advance, so that adding flow never
+		 * moves the annotations around. Demand is added later on. */
+		const LinkGraph::EdgeList &links = this->link_graph.edges[i];
+		EdgeAnnotationList &node_edges = this->edges[i];
+		node_edges.resize(links.size());
+		for (uint j = 0; j < links.size(); ++j) {
+			node_edges[j].Init(links[j].dest);
+		}
+		this->nodes[i].sorted_edges = (uint)links.size();
+	}
+}
+
+/**
+ * Compare two edge annotations by destination.
+ * @param a First annotation.
+ * @param b Second annotation.
+ * @return Negative if \a a goes to a node before \a b, positive if after, 0 otherwise.
+ */
+/* static */ int CDECL LinkGraphJob::EdgeAnnotationSorter(const EdgeAnnotation *a, const EdgeAnnotation *b)
+{
+	return (int)a->dest - (int)b->dest;
+}
+
+/**
+ * Sort the annotations at the end of a list of edge annotations, merge them
+ * into the sorted front and add up the demands delivered to the same
+ * destination. Sorting a batch of deliveries at once is much cheaper than
+ * inserting each delivery at its place, which moves the annotations behind it
+ * around.
+ * @param annos Annotations of the edges starting at a node.
+ * @param sorted Number of annotations at the front of \a annos that are sorted already.
+ */
+/* static */ void LinkGraphJob::MergeAnnotations(EdgeAnnotationList &annos, uint sorted)
+{
+	if (sorted == annos.size()) return;
+	QSortT(&annos[sorted], (uint)annos.size() - sorted, &LinkGraphJob::EdgeAnnotationSorter);
+
+	EdgeAnnotationList merged;
+	merged.reserve(annos.size());
+	EdgeAnnotationList::const_iterator old_it = annos.begin();
+	EdgeAnnotationList::const_iterator old_end = annos.begin() + sorted;
+	EdgeAnnotationList::const_iterator new_it = old_end;
+	while (old_it != old_end || new_it != annos.end()) {
+		bool take_old = new_it == annos.end() || (old_it != old_end && old_it->dest <= new_it->dest);
+		const EdgeAnnotation &anno = take_old ? *old_it++ : *new_it++;
+		if (!merged.empty() && merged.back().dest == anno.dest) {
+			merged.back().demand += anno.demand;
+			merged.back().unsatisfied_demand += anno.unsatisfied_demand;
+		} else {
+			merged.push_back(anno);
 		}
 	}
+	annos.swap(merged);
+}
+
+/**
+ * Sort the edge annotations of all nodes by destination again after the demand
+ * calculation and merge the demands delivered to the same destination in
+ * several rounds.
+ */
+void LinkGraphJob::MergeDemands()
+{
+	for (uint i = 0; i < this->edges.size(); ++i) {
+		MergeAnnotations(this->edges[i], this->nodes[i].sorted_edges);
+		this->nodes[i].sorted_edges = (uint)this->edges[i].size();
+	}
 }
 
 /**
  * Initialize a linkgraph job edge.
+ * @param dest Destination of the edge.
  */
-void LinkGraphJob::EdgeAnnotation::Init()
+void LinkGraphJob::EdgeAnnotation::Init(NodeID dest)
 {
+	this->dest = dest;
 	this->demand = 0;
 	this->flow = 0;
 	this->unsatisfied_demand = 0;
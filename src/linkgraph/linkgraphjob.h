@@ -15,9 +15,12 @@
 #include "../thread/thread.h"
 #include "linkgraph.h"
 #include <list>
+#include <vector>
 
 class LinkGraphJob;
 class Path;
+class WorkerPool;
+class WorkerPoolBatch;
 typedef std::list<Path *> PathList;
 
 /** Type of the pool for link graph jobs. */
@@ -31,27 +34,72 @@ extern LinkGraphJobPool _link_graph_job_pool;
 class LinkGraphJob : public LinkGraphJobPool::PoolItem<&_link_graph_job_pool>{
 private:
 	/**
-	 * Annotation for a link graph edge.
+	 * Annotation for a link graph edge or for a pair of nodes with demand
+	 * between them.
 	 */
 	struct EdgeAnnotation {
+		NodeID dest;             ///< Destination of the edge.
 		uint demand;             ///< Transport demand between the nodes.
 		uint unsatisfied_demand; ///< Demand over this edge that hasn't been satisfied yet.
 		uint flow;               ///< Planned flow over this edge.
-		void Init();
+		void Init(NodeID dest);
 	};
 
+	/** Annotations for the edges starting at one node, sorted by destination except during the demand calculation. */
+	typedef std::vector<EdgeAnnotation> EdgeAnnotationList;
+
+	/** Annotation new ones are copied from. */
+	static const EdgeAnnotation EMPTY_ANNOTATION;
+
+	/**
+	 * Get the position an annotation has or would have in a list of annotations.
+	 * @param annos Annotations of the edges starting at a node.
+	 * @param to Destination of the edge.
+	 * @param end Number of annotations at the front of \a annos to search in.
+	 * @return Index of the first annotation in \a annos not going to a node before \a to.
+	 */
+	inline static uint FindAnnotationIndex(const EdgeAnnotationList &annos, NodeID to, uint end)
+	{
+		uint begin = 0;
+		while (begin < end) {
+			uint middle = (begin + end) / 2;
+			if (annos[middle].dest < to) {
+				begin = middle + 1;
+			} else {
+				end = middle;
+			}
+		}
+		return begin;
+	}
+
+	/**
+	 * Find an annotation in a list of annotations.
+	 * @param annos Annotations of the edges starting at a node.
+	 * @param to Destination of the edge.
+	 * @return The annotation, or NULL if there is none for \a to.
+	 */
+	inline static EdgeAnnotation *FindAnnotation(EdgeAnnotationList &annos, NodeID to)
+	{
+		uint index = FindAnnotationIndex(annos, to, (uint)annos.size());
+		return index < annos.size() && annos[index].dest == to ? &annos[index] : NULL;
+	}
+
+	static int CDECL EdgeAnnotationSorter(const EdgeAnnotation *a, const EdgeAnnotation *b);
+	static void MergeAnnotations(EdgeAnnotationList &annos, uint sorted);
+
 	/**
 	 * Annotation for a link graph node.
 	 */
 	struct NodeAnnotation {
 		uint undelivered_supply; ///< Amount of supply that hasn't been distributed yet.
+		uint sorted_edges;       ///< Number of edge annotations at the front that are sorted by destination.
 		PathList paths;          ///< Paths through this node, sorted so that those with flow == 0 are in the back.
 		FlowStatMap flows;       ///< Planned flows to other nodes.
 		void Init(uint supply);
 	};
 
 	typedef SmallVector<NodeAnnotation, 16> NodeAnnotationVector;
-	typedef SmallMatrix<EdgeAnnotation> EdgeAnnotationMatrix;
+	typedef std::vector<EdgeAnnotationList> EdgeAnnotationListVector;
 
 	friend const SaveLoad *GetLinkGraphJobDesc();
 	friend class LinkGraphSchedule;
@@ -59,10 +107,14 @@ private:
 protected:
 	const LinkGraph link_graph;       ///< Link graph to by analyzed. Is copied when job is started and mustn't be modified later.
 	const LinkGraphSettings settings; ///< Copy of _settings_game.linkgraph at spawn time.
-	ThreadObject *thread;             ///< Thread the job is running in or NULL if it's running in the main thread.
+	WorkerPoolBatch *batch;           ///< Batch the job is queued as in the pool, or NULL if it's not running.
+	WorkerPool *workers;              ///< Pool the job is run on and can run parts of its calculation on.
+	uint64 post_time;                 ///< Time the job was handed to the pool, in microseconds.
+	uint64 start_time;                ///< Time a thread started calculating the job, in microseconds.
+	uint64 end_time;                  ///< Time the calculation of the job ended, in microseconds.
 	Date join_date;                   ///< Date when the job is to be joined.
 	NodeAnnotationVector nodes;       ///< Extra node data necessary for link graph calculation.
-	EdgeAnnotationMatrix edges;       ///< Extra edge data necessary for link graph calculation.
+	EdgeAnnotationListVector edges;   ///< Extra edge data necessary for link graph calculation.
 
 	void EraseFlows(NodeID from);
 	void JoinThread();
@@ -72,43 +124,49 @@ public:
 
 	/**
 	 * A job edge. Wraps a link graph edge and an edge annotation. The
-	 * annotation can be modified, the edge is constant.
+	 * annotation can be modified, the edge is constant. If there is neither
+	 * a link nor demand between the nodes there is no annotation. Such an
+	 * edge reads as empty and must not be modified.
 	 */
 	class Edge : public LinkGraph::ConstEdge {
 	private:
-		EdgeAnnotation &anno; ///< Annotation being wrapped.
+		EdgeAnnotation *anno; ///< Annotation being wrapped, or NULL if there is none.
 	public:
 		/**
 		 * Constructor.
 		 * @param edge Link graph edge to be wrapped.
-		 * @param anno Annotation to be wrapped.
+		 * @param anno Annotation to be wrapped, or NULL if there is none.
 		 */
-		Edge(const LinkGraph::BaseEdge &edge, EdgeAnnotation &anno) :
+		Edge(const LinkGraph::BaseEdge &edge, EdgeAnnotation *anno) :
 				LinkGraph::ConstEdge(edge), anno(anno) {}
 
 		/**
 		 * Get the transport demand between end the points of the edge.
 		 * @return Demand.
 		 */
-		uint Demand() const { return this->anno.demand; }
+		uint Demand() const { return this->anno != NULL ? this->anno->demand : 0; }
 
 		/**
 		 * Get the transport demand that hasn't been satisfied by flows, yet.
 		 * @return Unsatisfied demand.
 		 */
-		uint UnsatisfiedDemand() const { return this->anno.unsatisfied_demand; }
+		uint UnsatisfiedDemand() const { return this->anno != NULL ? this->anno->unsatisfied_demand : 0; }
 
 		/**
 		 * Get the total flow on the edge.
 		 * @return Flow.
 		 */
-		uint Flow() const { return this->anno.flow; }
+		uint Flow() const { return this->anno != NULL ? this->anno->flow : 0; }
 
 		/**
 		 * Add some flow.
 		 * @param flow Flow to be added.
 		 */
-		void AddFlow(uint flow) { this->anno.flow += flow; }
+		void AddFlow(uint flow)
+		{
+			assert(this->anno != NULL);
+			this->anno->flow += flow;
+		}
 
 		/**
 		 * Remove some flow.
@@ -116,8 +174,8 @@ public:
 		 */
 		void RemoveFlow(uint flow)
 		{
-			assert(flow <= this->anno.flow);
-			this->anno.flow -= flow;
+			assert(this->anno != NULL && flow <= this->anno->flow);
+			this->anno->flow -= flow;
 		}
 
 		/**
@@ -126,8 +184,9 @@ public:
 		 */
 		void AddDemand(uint demand)
 		{
-			this->anno.demand += demand;
-			this->anno.unsatisfied_demand += demand;
+			assert(this->anno != NULL);
+			this->anno->demand += demand;
+			this->anno->unsatisfied_demand += demand;
 		}
 
 		/**
@@ -136,26 +195,67 @@ public:
 		 */
 		void SatisfyDemand(uint demand)
 		{
-			assert(demand <= this->anno.unsatisfied_demand);
-			this->anno.unsatisfied_demand -= demand;
+			assert(this->anno != NULL && demand <= this->anno->unsatisfied_demand);
+			this->anno->unsatisfied_demand -= demand;
 		}
 	};
 
 	/**
-	 * Iterator for job edges.
+	 * Iterator for job edges. The annotations hold an entry for every edge
+	 * and are sorted the same way, so they are walked alongside the edges.
 	 */
-	class EdgeIterator : public LinkGraph::BaseEdgeIterator<const LinkGraph::BaseEdge, Edge, EdgeIterator> {
-		EdgeAnnotation *base_anno; ///< Array of annotations to be (indirectly) iterated.
+	class EdgeIterator : public LinkGraph::BaseEdgeIterator<const LinkGraph::EdgeList, Edge, EdgeIterator> {
+		EdgeAnnotationList *base_anno; ///< Annotations to be (indirectly) iterated.
+		uint current_anno;             ///< Index of the annotation of the current edge.
+
+		/**
+		 * Move to the annotation of the current edge.
+		 */
+		void FindCurrentAnnotation()
+		{
+			if (this->base == NULL) return;
+			while (this->current < this->base->size() && (*this->base_anno)[this->current_anno].dest != (*this->base)[this->current].dest) {
+				this->current_anno++;
+				assert(this->current_anno < this->base_anno->size());
+			}
+		}
+
 	public:
 		/**
 		 * Constructor.
-		 * @param base Array of edges to be iterated.
-		 * @param base_anno Array of annotations to be iterated.
-		 * @param current Start offset of iteration.
+		 * @param base List of edges to be iterated.
+		 * @param base_anno Annotations to be iterated.
+		 * @param current Index of the first edge to be iterated.
 		 */
-		EdgeIterator(const LinkGraph::BaseEdge *base, EdgeAnnotation *base_anno, NodeID current) :
-				LinkGraph::BaseEdgeIterator<const LinkGraph::BaseEdge, Edge, EdgeIterator>(base, current),
-				base_anno(base_anno) {}
+		EdgeIterator(const LinkGraph::EdgeList *base, EdgeAnnotationList *base_anno, uint current) :
+				LinkGraph::BaseEdgeIterator<const LinkGraph::EdgeList, Edge, EdgeIterator>(base, current),
+				base_anno(base_anno), current_anno(0)
+		{
+			this->FindCurrentAnnotation();
+		}
+
+		/**
+		 * Prefix-increment. Has to be repeated here as the annotation has to
+		 * be moved along.
+		 * @return This.
+		 */
+		EdgeIterator &operator++()
+		{
+			this->current++;
+			this->FindCurrentAnnotation();
+			return *this;
+		}
+
+		/**
+		 * Postfix-increment.
+		 * @return Version of this before increment.
+		 */
+		EdgeIterator operator++(int)
+		{
+			EdgeIterator ret(*this);
+			this->operator++();
+			return ret;
+		}
 
 		/**
 		 * Dereference.
@@ -164,7 +264,8 @@ public:
 		 */
 		SmallPair<NodeID, Edge> operator*() const
 		{
-			return SmallPair<NodeID, Edge>(this->current, Edge(this->base[this->current], this->base_anno[this->current]));
+			const LinkGraph::BaseEdge &edge = (*this->base)[this->current];
+			return SmallPair<NodeID, Edge>(edge.dest, Edge(edge, &(*this->base_anno)[this->current_anno]));
 		}
 
 		/**
@@ -177,14 +278,92 @@ public:
 		}
 	};
 
+	/**
+	 * Iterator for the pairs of nodes with a link or demand between them. The
+	 * edges are walked alongside the annotations. Pairs without a link get an
+	 * empty link graph edge.
+	 */
+	class DemandIterator : public LinkGraph::BaseEdgeIterator<EdgeAnnotationList, Edge, DemandIterator> {
+		const LinkGraph::EdgeList *base_edges; ///< Edges to be (indirectly) iterated.
+		uint current_edge;                     ///< Index of the first edge not going to a node before the current one.
+
+		/**
+		 * Move to the first edge not going to a node before the current one.
+		 */
+		void FindCurrentEdge()
+		{
+			if (this->current == this->base->size()) return;
+			NodeID dest = (*this->base)[this->current].dest;
+			while (this->current_edge < this->base_edges->size() && (*this->base_edges)[this->current_edge].dest < dest) {
+				this->current_edge++;
+			}
+		}
+
+	public:
+		/**
+		 * Constructor.
+		 * @param base Annotations to be iterated.
+		 * @param base_edges List of edges to be iterated.
+		 * @param current Index of the first annotation to be iterated.
+		 */
+		DemandIterator(EdgeAnnotationList *base, const LinkGraph::EdgeList *base_edges, uint current) :
+				LinkGraph::BaseEdgeIterator<EdgeAnnotationList, Edge, DemandIterator>(base, current),
+				base_edges(base_edges), current_edge(0)
+		{
+			this->FindCurrentEdge();
+		}
+
+		/**
+		 * Prefix-increment.
+		 * @return This.
+		 */
+		DemandIterator &operator++()
+		{
+			this->current++;
+			this->FindCurrentEdge();
+			return *this;
+		}
+
+		/**
+		 * Postfix-increment.
+		 * @return Version of this before increment.
+		 */
+		DemandIterator operator++(int)
+		{
+			DemandIterator ret(*this);
+			this->operator++();
+			return ret;
+		}
+
+		/**
+		 * Dereference.
+		 * @return Pair of the edge currently pointed to and the ID of its
+		 *         other end.
+		 */
+		SmallPair<NodeID, Edge> operator*() const
+		{
+			EdgeAnnotation &anno = (*this->base)[this->current];
+			bool linked = this->current_edge < this->base_edges->size() && (*this->base_edges)[this->current_edge].dest == anno.dest;
+			return SmallPair<NodeID, Edge>(anno.dest, Edge(linked ? (*this->base_edges)[this->current_edge] : LinkGraph::EMPTY_EDGE, &anno));
+		}
+
+		/**
+		 * Dereference.
+		 * @return Fake pointer to pair of NodeID/Edge.
+		 */
+		FakePointer operator->() const {
+			return FakePointer(this->operator*());
+		}
+	};
+
 	/**
 	 * Link graph job node. Wraps a constant link graph node and a modifiable
 	 * node annotation.
 	 */
 	class Node : public LinkGraph::ConstNode {
 	private:
-		NodeAnnotation &node_anno;  ///< Annotation being wrapped.
-		EdgeAnnotation *edge_annos; ///< Edge annotations belonging to this node.
+		NodeAnnotation &node_anno;       ///< Annotation being wrapped.
+		EdgeAnnotationList &edge_annos;  ///< Edge annotations belonging to this node.
 	public:
 
 		/**
@@ -199,25 +378,57 @@ public:
 
 		/**
 		 * Retrieve an edge starting at this node. Mind that this returns an
-		 * object, not a reference.
+		 * object, not a reference. If there is neither a link nor demand
+		 * between the nodes, the returned edge is empty and must not be
+		 * modified.
 		 * @param to Remote end of the edge.
 		 * @return Edge between this node and "to".
 		 */
-		Edge operator[](NodeID to) const { return Edge(this->edges[to], this->edge_annos[to]); }
+		Edge operator[](NodeID to) const
+		{
+			const LinkGraph::BaseEdge *edge = LinkGraph::FindEdge(this->edges, to);
+			return Edge(edge != NULL ? *edge : LinkGraph::EMPTY_EDGE, LinkGraphJob::FindAnnotation(this->edge_annos, to));
+		}
 
 		/**
 		 * Iterator for the "begin" of the edge array. Only edges with capacity
 		 * are iterated. The others are skipped.
 		 * @return Iterator pointing to the first edge.
 		 */
-		EdgeIterator Begin() const { return EdgeIterator(this->edges, this->edge_annos, index); }
+		EdgeIterator Begin() const { return EdgeIterator(&this->edges, &this->edge_annos, 0); }
 
 		/**
 		 * Iterator for the "end" of the edge array. Only edges with capacity
 		 * are iterated. The others are skipped.
 		 * @return Iterator pointing beyond the last edge.
 		 */
-		EdgeIterator End() const { return EdgeIterator(this->edges, this->edge_annos, INVALID_NODE); }
+		EdgeIterator End() const { return EdgeIterator(&this->edges, &this->edge_annos, (uint)this->edges.size()); }
+
+		/**
+		 * Iterator for the "begin" of the pairs of this node and nodes it
+		 * has a link or demand to.
+		 * @return Iterator pointing to the first pair.
+		 */
+		DemandIterator DemandBegin() const { return DemandIterator(&this->edge_annos, &this->edges, 0); }
+
+		/**
+		 * Iterator for the "end" of the pairs of this node and nodes it
+		 * has a link or demand to.
+		 * @return Iterator pointing beyond the last pair.
+		 */
+		DemandIterator DemandEnd() const { return DemandIterator(&this->edge_annos, &this->edges, (uint)this->edge_annos.size()); }
+
+		/**
+		 * Check if any demand starting at this node hasn't been satisfied, yet.
+		 * @return True if there is unsatisfied demand to some other node.
+		 */
+		bool HasUnsatisfiedDemand() const
+		{
+			for (EdgeAnnotationList::const_iterator it = this->edge_annos.begin(); it != this->edge_annos.end(); ++it) {
+				if (it->unsatisfied_demand > 0) return true;
+			}
+			return false;
+		}
 
 		/**
 		 * Get amount of supply that hasn't been delivered, yet.
@@ -251,14 +462,37 @@ public:
 		const PathList &Paths() const { return this->node_anno.paths; }
 
 		/**
-		 * Deliver some supply, adding demand to the respective edge.
+		 * Deliver some supply, adding demand to the respective edge. Demand
+		 * to a destination that isn't in the sorted part of the annotations
+		 * yet is appended unsorted. The unsorted part is merged in when it
+		 * gets longer than the sorted one, and LinkGraphJob::MergeDemands()
+		 * has to be called before the edges are looked up again.
 		 * @param to Destination for supply.
 		 * @param amount Amount of supply to be delivered.
 		 */
 		void DeliverSupply(NodeID to, uint amount)
 		{
 			this->node_anno.undelivered_supply -= amount;
-			(*this)[to].AddDemand(amount);
+			if (amount == 0) return;
+
+			uint sorted = this->node_anno.sorted_edges;
+			uint index = LinkGraphJob::FindAnnotationIndex(this->edge_annos, to, sorted);
+			if (index < sorted && this->edge_annos[index].dest == to) {
+				this->edge_annos[index].demand += amount;
+				this->edge_annos[index].unsatisfied_demand += amount;
+				return;
+			}
+
+			this->edge_annos.push_back(EMPTY_ANNOTATION);
+			EdgeAnnotation &anno = this->edge_annos.back();
+			anno.Init(to);
+			anno.demand = amount;
+			anno.unsatisfied_demand = amount;
+
+			if (this->edge_annos.size() > 2 * sorted) {
+				LinkGraphJob::MergeAnnotations(this->edge_annos, sorted);
+				this->node_anno.sorted_edges = (uint)this->edge_annos.size();
+			}
 		}
 	};
 
@@ -266,13 +500,14 @@ public:
 	 * Bare constructor, only for save/load. link_graph, join_date and actually
 	 * settings have to be brutally const-casted in order to populate them.
 	 */
-	LinkGraphJob() : settings(_settings_game.linkgraph), thread(NULL),
-			join_date(INVALID_DATE) {}
+	LinkGraphJob() : settings(_settings_game.linkgraph), batch(NULL),
+			workers(NULL), post_time(0), start_time(0), end_time(0), join_date(INVALID_DATE) {}
 
 	LinkGraphJob(const LinkGraph &orig);
 	~LinkGraphJob();
 
 	void Init();
+	void MergeDemands();
 
 	/**
 	 * Check if job is supposed to be finished.
@@ -280,6 +515,8 @@ public:
 	 */
 	inline bool IsFinished() const { return this->join_date <= _date; }
 
+	bool IsJobCompleted() const;
+
 	/**
 	 * Get the date when the job should be finished.
 	 * @return Join date.
@@ -292,6 +529,12 @@ public:
 	 */
 	inline void ShiftJoinDate(int interval) { this->join_date += interval; }
 
+	/**
+	 * Get the pool the job can run parts of its calculation on.
+	 * @return Worker pool.
+	 */
+	inline WorkerPool *Workers() const { return this->workers; }
+
 	/**
 	 * Get the link graph settings for this component.
 	 * @return Settings.
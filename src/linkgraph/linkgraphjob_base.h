@@ -19,5 +19,6 @@
 typedef LinkGraphJob::Node Node;
 typedef LinkGraphJob::Edge Edge;
 typedef LinkGraphJob::EdgeIterator EdgeIterator;
+typedef LinkGraphJob::DemandIterator DemandIterator;
 
 #endif /* LINKGRAPHJOB_BASE_H */
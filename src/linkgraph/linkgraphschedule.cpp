@@ -15,6 +15,11 @@
 #include "demands.h"
 #include "mcf.h"
 #include "flowmapper.h"
+#include "../settings_type.h"
+#include "../tick_profiler.h"
+#include "../thread/worker_pool.h"
+#include "../command_func.h"
+#include "../network/network.h"
 
 #include "../safeguards.h"
 
@@ -25,6 +30,8 @@
  */
 /* static */ LinkGraphSchedule LinkGraphSchedule::instance;
 
+/* static */ WorkerPool *LinkGraphSchedule::workers = NULL;
+
 /**
  * Start the next job in the schedule.
  */
@@ -40,6 +47,17 @@ void LinkGraphSchedule::SpawnNext()
 	}
 	assert(next == LinkGraph::Get(next->index));
 	this->schedule.pop_front();
+
+	QueueDateMap::iterator queued = this->queue_dates.find(next->index);
+	if (queued != this->queue_dates.end()) {
+		LinkGraphJobStats &stats = this->stats[next->Cargo()];
+		uint wait = _date - queued->second;
+		stats.spawned++;
+		stats.schedule_wait += wait;
+		stats.max_schedule_wait = max(stats.max_schedule_wait, wait);
+		this->queue_dates.erase(queued);
+	}
+
 	if (LinkGraphJob::CanAllocateItem()) {
 		LinkGraphJob *job = new LinkGraphJob(*next);
 		job->SpawnThread();
@@ -59,7 +77,29 @@ void LinkGraphSchedule::JoinNext()
 	if (!next->IsFinished()) return;
 	this->running.pop_front();
 	LinkGraphID id = next->LinkGraphIndex();
-	delete next; // implicitly joins the thread
+	LinkGraphJobStats &stats = this->stats[next->Cargo()];
+
+	if (next->IsJobCompleted()) {
+		next->JoinThread();
+	} else {
+		/* The game stands still until the job is done. */
+		uint64 begin = GetProfilerTime();
+		next->JoinThread();
+		uint64 stall_time = GetProfilerTime() - begin;
+		stats.stalls++;
+		stats.stall_time += stall_time;
+		stats.max_stall_time = max(stats.max_stall_time, stall_time);
+	}
+
+	uint64 pool_wait = next->start_time - next->post_time;
+	uint64 run_time = next->end_time - next->start_time;
+	stats.joined++;
+	stats.pool_wait += pool_wait;
+	stats.max_pool_wait = max(stats.max_pool_wait, pool_wait);
+	stats.run_time += run_time;
+	stats.max_run_time = max(stats.max_run_time, run_time);
+
+	delete next;
 	if (LinkGraph::IsValidID(id)) {
 		LinkGraph *lg = LinkGraph::Get(id);
 		this->Unqueue(lg); // Unqueue to avoid double-queueing recycled IDs.
@@ -67,17 +107,98 @@ void LinkGraphSchedule::JoinNext()
 	}
 }
 
+/**
+ * Postpone joining the jobs that are due at the next join tick, but are not
+ * done yet. Only the server may call this; whether a job is done differs
+ * between clients, so the postponement is sent to everyone as a command.
+ * @param join_date Date of the next join tick.
+ */
+void LinkGraphSchedule::PostponeOverdueJobs(Date join_date)
+{
+	/* Look at the jobs JoinNext() would join at join_date. */
+	uint count = 0;
+	for (JobList::iterator i(this->running.begin()); i != this->running.end() && count < _settings_game.linkgraph.jobs_per_interval; ++i, ++count) {
+		LinkGraphJob *job = *i;
+		if (job->JoinDate() > join_date) return;
+		if (!job->IsJobCompleted()) {
+			/* JoinNext() doesn't look past this job anyway. */
+			DoCommandP(0, job->index, job->JoinDate(), CMD_POSTPONE_LINKGRAPH_JOB);
+			return;
+		}
+	}
+}
+
+/**
+ * Join a job at the next join tick after its current join date.
+ * @param job The job to postpone.
+ */
+void LinkGraphSchedule::Postpone(LinkGraphJob *job)
+{
+	job->ShiftJoinDate(_settings_game.linkgraph.recalc_interval);
+	this->stats[job->Cargo()].postponed++;
+}
+
+/**
+ * Postpone joining a link graph job whose calculation is not done in time (server-only).
+ * @param tile unused
+ * @param flags operation to perform
+ * @param p1 the ID of the job
+ * @param p2 the join date the job has to have
+ * @param text unused
+ * @return the cost of this operation or an error
+ */
+CommandCost CmdPostponeLinkGraphJob(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32 p2, const char *text)
+{
+	if (!LinkGraphJob::IsValidID(p1)) return CMD_ERROR;
+	LinkGraphJob *job = LinkGraphJob::Get(p1);
+	/* The job may have been joined and its ID reused before the command arrived. */
+	if (job->JoinDate() != (Date)p2) return CMD_ERROR;
+
+	if (flags & DC_EXEC) LinkGraphSchedule::instance.Postpone(job);
+	return CommandCost();
+}
+
 /**
  * Run all handlers for the given Job. This method is tailored to
- * ThreadObject::New.
+ * WorkerPool::Post.
  * @param j Pointer to a link graph job.
+ * @param begin Unused.
+ * @param end Unused.
  */
-/* static */ void LinkGraphSchedule::Run(void *j)
+/* static */ void LinkGraphSchedule::Run(void *j, uint begin, uint end)
 {
 	LinkGraphJob *job = (LinkGraphJob *)j;
+	job->start_time = GetProfilerTime();
 	for (uint i = 0; i < lengthof(instance.handlers); ++i) {
 		instance.handlers[i]->Run(*job);
 	}
+	job->end_time = GetProfilerTime();
+}
+
+/**
+ * Get the pool the link graph jobs are run on. Jobs only wait for each
+ * other when all threads of the pool are busy.
+ * @return The pool; created when needed.
+ */
+/* static */ WorkerPool *LinkGraphSchedule::GetWorkers()
+{
+	if (workers == NULL) {
+		uint threads = _settings_client.gui.linkgraph_threads;
+		/* Automatic: one thread per core, but leave one core to the game. */
+		if (threads == 0) threads = max(GetCPUCoreCount(), 2U) - 1;
+		workers = new WorkerPool(threads);
+	}
+	return workers;
+}
+
+/**
+ * Stop the threads of the pool the jobs are run on. No job may be running.
+ * The pool is restarted with the current settings when it is needed again.
+ */
+/* static */ void LinkGraphSchedule::UninitializeWorkers()
+{
+	delete workers;
+	workers = NULL;
 }
 
 /**
@@ -92,15 +213,25 @@ void LinkGraphSchedule::SpawnAll()
 }
 
 /**
- * Clear all link graphs and jobs from the schedule.
+ * Wait until the calculations of all running jobs are done. The jobs stay in
+ * the running list and are joined at their join dates as usual.
  */
-/* static */ void LinkGraphSchedule::Clear()
+void LinkGraphSchedule::WaitForAll()
 {
-	for (JobList::iterator i(instance.running.begin()); i != instance.running.end(); ++i) {
+	for (JobList::iterator i(this->running.begin()); i != this->running.end(); ++i) {
 		(*i)->JoinThread();
 	}
+}
+
+/**
+ * Clear all link graphs and jobs from the schedule.
+ */
+/* static */ void LinkGraphSchedule::Clear()
+{
+	instance.WaitForAll();
 	instance.running.clear();
 	instance.schedule.clear();
+	instance.queue_dates.clear();
 }
 
 /**
@@ -116,6 +247,14 @@ void LinkGraphSchedule::ShiftDates(int interval)
 	FOR_ALL_LINK_GRAPH_JOBS(lgj) lgj->ShiftJoinDate(interval);
 }
 
+/**
+ * Forget the statistics about the jobs of all cargoes.
+ */
+void LinkGraphSchedule::ResetStats()
+{
+	memset(this->stats, 0, sizeof(this->stats));
+}
+
 /**
  * Create a link graph schedule and initialize its handlers.
  */
@@ -127,6 +266,7 @@ LinkGraphSchedule::LinkGraphSchedule()
 	this->handlers[3] = new FlowMapper(false);
 	this->handlers[4] = new MCFHandler<MCF2ndPass>;
 	this->handlers[5] = new FlowMapper(true);
+	this->ResetStats();
 }
 
 /**
@@ -141,17 +281,50 @@ LinkGraphSchedule::~LinkGraphSchedule()
 }
 
 /**
- * Spawn or join a link graph job or compress a link graph if any link graph is
+ * Get the number of ticks before a join tick at which the server checks
+ * whether the jobs to be joined are done. Commands the server sends are only
+ * executed frame_freq + 1 ticks later, so the postponement has to be sent
+ * at least that early to reach all clients before the join tick. A day of
+ * lead time also covers the commands queued before it.
+ * @return Number of ticks.
+ */
+static int GetOverdueCheckLead()
+{
+#ifdef ENABLE_NETWORK
+	return max<int>(DAY_TICKS, _settings_client.network.frame_freq + 1);
+#else
+	return DAY_TICKS;
+#endif
+}
+
+/**
+ * Spawn or join link graph jobs or compress a link graph if any link graph is
  * due to do so.
  */
 void OnTick_LinkGraph()
 {
+	Date interval = _settings_game.linkgraph.recalc_interval;
+	Date offset = _date % interval;
+	if (_settings_game.linkgraph.postpone_overdue_jobs && (!_networking || _network_server)) {
+		Date days = (interval / 2 - offset + interval) % interval;
+		int ticks = days * DAY_TICKS + LinkGraphSchedule::SPAWN_JOIN_TICK - _date_fract;
+		if (ticks < 0) {
+			/* Today's join tick has passed already. */
+			days += interval;
+			ticks += interval * DAY_TICKS;
+		}
+		if (ticks == GetOverdueCheckLead()) LinkGraphSchedule::instance.PostponeOverdueJobs(_date + days);
+	}
+
 	if (_date_fract != LinkGraphSchedule::SPAWN_JOIN_TICK) return;
-	Date offset = _date % _settings_game.linkgraph.recalc_interval;
 	if (offset == 0) {
-		LinkGraphSchedule::instance.SpawnNext();
-	} else if (offset == _settings_game.linkgraph.recalc_interval / 2) {
-		LinkGraphSchedule::instance.JoinNext();
+		for (uint i = 0; i < _settings_game.linkgraph.jobs_per_interval; i++) {
+			LinkGraphSchedule::instance.SpawnNext();
+		}
+	} else if (offset == interval / 2) {
+		for (uint i = 0; i < _settings_game.linkgraph.jobs_per_interval; i++) {
+			LinkGraphSchedule::instance.JoinNext();
+		}
 	}
 }
 
@@ -13,8 +13,10 @@
 #define LINKGRAPHSCHEDULE_H
 
 #include "linkgraph.h"
+#include <map>
 
 class LinkGraphJob;
+class WorkerPool;
 
 /**
  * A handler doing "something" on a link graph component. It must not keep any
@@ -35,31 +37,69 @@ public:
 	virtual void Run(LinkGraphJob &job) const = 0;
 };
 
+/** Statistics about how long the link graph jobs of a cargo waited and ran. */
+struct LinkGraphJobStats {
+	uint spawned;           ///< Number of jobs started.
+	uint64 schedule_wait;   ///< Sum of the days the link graphs waited in the schedule before their jobs were started.
+	uint max_schedule_wait; ///< Longest time a link graph waited in the schedule, in days.
+	uint joined;            ///< Number of jobs joined.
+	uint64 pool_wait;       ///< Sum of the times the jobs waited for a thread of the pool, in microseconds.
+	uint64 max_pool_wait;   ///< Longest time a job waited for a thread of the pool, in microseconds.
+	uint64 run_time;        ///< Sum of the times the calculations of the jobs took, in microseconds.
+	uint64 max_run_time;    ///< Longest time the calculation of a job took, in microseconds.
+	uint postponed;         ///< Number of times a job was not done in time and its join was postponed.
+	uint stalls;            ///< Number of jobs the game had to wait for when joining them.
+	uint64 stall_time;      ///< Sum of the times the game waited for jobs to be done, in microseconds.
+	uint64 max_stall_time;  ///< Longest time the game waited for a job to be done, in microseconds.
+};
+
 class LinkGraphSchedule {
 private:
 	LinkGraphSchedule();
 	~LinkGraphSchedule();
 	typedef std::list<LinkGraph *> GraphList;
 	typedef std::list<LinkGraphJob *> JobList;
+	typedef std::map<LinkGraphID, Date> QueueDateMap;
 	friend const SaveLoad *GetLinkGraphScheduleDesc();
 
+	static WorkerPool *workers; ///< Pool the jobs are run on.
+
 protected:
-	ComponentHandler *handlers[6]; ///< Handlers to be run for each job.
-	GraphList schedule;            ///< Queue for new jobs.
-	JobList running;               ///< Currently running jobs.
+	ComponentHandler *handlers[6];     ///< Handlers to be run for each job.
+	GraphList schedule;                ///< Queue for new jobs.
+	JobList running;                   ///< Currently running jobs.
+	QueueDateMap queue_dates;          ///< Dates the link graphs in the schedule were queued at. Not saved; only used for statistics.
+	LinkGraphJobStats stats[NUM_CARGO]; ///< Statistics about the jobs per cargo.
 
 public:
 	/* This is a tick where not much else is happening, so a small lag might go unnoticed. */
 	static const uint SPAWN_JOIN_TICK = 21; ///< Tick when jobs are spawned or joined every day.
 	static LinkGraphSchedule instance;
 
-	static void Run(void *j);
+	static void Run(void *j, uint begin, uint end);
 	static void Clear();
+	static WorkerPool *GetWorkers();
+	static void UninitializeWorkers();
 
 	void SpawnNext();
 	void JoinNext();
+	void PostponeOverdueJobs(Date join_date);
+	void Postpone(LinkGraphJob *job);
 	void SpawnAll();
+	void WaitForAll();
 	void ShiftDates(int interval);
+	void ResetStats();
+
+	/**
+	 * Get the statistics about the jobs of a cargo.
+	 * @param cargo Cargo to get the statistics for.
+	 * @return The statistics.
+	 */
+	const LinkGraphJobStats &GetStats(CargoID cargo) const
+	{
+		assert(cargo < NUM_CARGO);
+		return this->stats[cargo];
+	}
 
 	/**
 	 * Queue a link graph for execution.
@@ -69,13 +109,18 @@ public:
 	{
 		assert(LinkGraph::Get(lg->index) == lg);
 		this->schedule.push_back(lg);
+		this->queue_dates[lg->index] = _date;
 	}
 
 	/**
 	 * Remove a link graph from the execution queue.
 	 * @param lg Link graph to be removed.
 	 */
-	void Unqueue(LinkGraph *lg) { this->schedule.remove(lg); }
+	void Unqueue(LinkGraph *lg)
+	{
+		this->schedule.remove(lg);
+		this->queue_dates.erase(lg->index);
+	}
 };
 
 #endif /* LINKGRAPHSCHEDULE_H */
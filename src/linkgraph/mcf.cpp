@@ -2,6 +2,7 @@
 
 #include "../stdafx.h"
 #include "../core/math_func.hpp"
+#include "../thread/worker_pool.h"
 #include "mcf.h"
 #include <set>
 
@@ -73,14 +74,14 @@ public:
 };
 
 /**
- * Iterator class for getting the edges in the order of their next_edge
- * members.
+ * Iterator class for getting the edges in the order of their destinations.
  */
 class GraphEdgeIterator {
 private:
-	LinkGraphJob &job; ///< Job being executed
-	EdgeIterator i;    ///< Iterator pointing to current edge.
-	EdgeIterator end;  ///< Iterator pointing beyond last edge.
+	LinkGraphJob &job;    ///< Job being executed
+	EdgeIterator i;       ///< Iterator pointing to next edge.
+	EdgeIterator end;     ///< Iterator pointing beyond last edge.
+	EdgeIterator current; ///< Iterator pointing to the edge last returned.
 
 public:
 
@@ -89,7 +90,7 @@ public:
 	 * @param job Job to iterate on.
 	 */
 	GraphEdgeIterator(LinkGraphJob &job) : job(job),
-		i(NULL, NULL, INVALID_NODE), end(NULL, NULL, INVALID_NODE)
+		i(NULL, NULL, 0), end(NULL, NULL, 0), current(NULL, NULL, 0)
 	{}
 
 	/**
@@ -109,7 +110,20 @@ public:
 	 */
 	NodeID Next()
 	{
-		return this->i != this->end ? (this->i++)->first : INVALID_NODE;
+		if (this->i == this->end) return INVALID_NODE;
+		this->current = this->i++;
+		return this->current->first;
+	}
+
+	/**
+	 * Get the edge last returned by Next().
+	 * @param from Unused.
+	 * @param to Unused.
+	 * @return The edge.
+	 */
+	Edge GetEdge(NodeID from, NodeID to) const
+	{
+		return this->current->second;
 	}
 };
 
@@ -168,6 +182,17 @@ public:
 		if (this->it == this->end) return INVALID_NODE;
 		return this->station_to_node[(this->it++)->second];
 	}
+
+	/**
+	 * Get the edge to the node last returned by Next().
+	 * @param from Node the flows were retrieved from.
+	 * @param to Node last returned by Next().
+	 * @return The edge.
+	 */
+	Edge GetEdge(NodeID from, NodeID to) const
+	{
+		return this->job[from][to];
+	}
 };
 
 /**
@@ -257,7 +282,7 @@ void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
 		iter.SetNode(source_node, from);
 		for (NodeID to = iter.Next(); to != INVALID_NODE; to = iter.Next()) {
 			if (to == from) continue; // Not a real edge but a consumption sign.
-			Edge edge = this->job[from][to];
+			Edge edge = iter.GetEdge(from, to);
 			uint capacity = edge.Capacity();
 			if (this->max_saturation != UINT_MAX) {
 				capacity *= this->max_saturation;
@@ -276,6 +301,46 @@ void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
 	}
 }
 
+/**
+ * Run a part of the path searches of a batch.
+ * @param data The PathSearch describing the batch.
+ * @param begin Index of the first search to run.
+ * @param end Index after the last search to run.
+ */
+template<class Tannotation, class Tedge_iterator>
+/* static */ void MultiCommodityFlow::RunPathSearch(void *data, uint begin, uint end)
+{
+	const PathSearch *search = (const PathSearch *)data;
+	for (uint i = begin; i < end; ++i) {
+		uint offset = search->offsets[i];
+		search->mcf->Dijkstra<Tannotation, Tedge_iterator>(search->first + offset, search->paths[offset]);
+	}
+}
+
+/**
+ * Search the paths from a batch of sources. The searches only read the job,
+ * so they are run in parallel on the job's worker pool. As all of them see the
+ * flows as they were before the batch, the result doesn't depend on the
+ * number of threads. Sources without unsatisfied demand are skipped, as their
+ * paths wouldn't be used anyway.
+ * @param first First source of the batch.
+ * @param count Number of sources in the batch.
+ * @param paths Paths for each source of the batch; empty for skipped sources.
+ */
+template<class Tannotation, class Tedge_iterator>
+void MultiCommodityFlow::FindPaths(NodeID first, uint count, std::vector<PathVector> &paths)
+{
+	paths.resize(count);
+	this->offsets.Clear();
+	for (uint offset = 0; offset < count; ++offset) {
+		assert(paths[offset].empty());
+		if (this->job[first + offset].HasUnsatisfiedDemand()) *this->offsets.Append() = offset;
+	}
+
+	PathSearch search = { this, first, this->offsets.Begin(), &paths[0] };
+	this->job.Workers()->ParallelFor(&RunPathSearch<Tannotation, Tedge_iterator>, &search, this->offsets.Length());
+}
+
 /**
  * Clean up paths that lead nowhere and the root path.
  * @param source_id ID of the root node.
@@ -469,37 +534,46 @@ bool MCF1stPass::EliminateCycles()
  */
 MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
-	PathVector paths;
+	std::vector<PathVector> batch_paths;
 	uint size = job.Size();
 	uint accuracy = job.Settings().accuracy;
+	uint batch_size = job.Settings().mcf_batch_size;
 	bool more_loops;
 
 	do {
 		more_loops = false;
-		for (NodeID source = 0; source < size; ++source) {
+		for (uint first = 0; first < size; first += batch_size) {
+			uint count = min(batch_size, size - first);
 			/* First saturate the shortest paths. */
-			this->Dijkstra<DistanceAnnotation, GraphEdgeIterator>(source, paths);
-
-			for (NodeID dest = 0; dest < size; ++dest) {
-				Edge edge = job[source][dest];
-				if (edge.UnsatisfiedDemand() > 0) {
-					Path *path = paths[dest];
-					assert(path != NULL);
-					/* Generally only allow paths that don't exceed the
-					 * available capacity. But if no demand has been assigned
-					 * yet, make an exception and allow any valid path *once*. */
-					if (path->GetFreeCapacity() > 0 && this->PushFlow(edge, path,
-							accuracy, this->max_saturation) > 0) {
-						/* If a path has been found there is a chance we can
-						 * find more. */
-						more_loops = more_loops || (edge.UnsatisfiedDemand() > 0);
-					} else if (edge.UnsatisfiedDemand() == edge.Demand() &&
-							path->GetFreeCapacity() > INT_MIN) {
-						this->PushFlow(edge, path, accuracy, UINT_MAX);
+			this->FindPaths<DistanceAnnotation, GraphEdgeIterator>(first, count, batch_paths);
+
+			/* Push the flows in the order of the sources. */
+			for (NodeID source = first; source < first + count; ++source) {
+				PathVector &paths = batch_paths[source - first];
+				if (paths.empty()) continue;
+
+				Node node = job[source];
+				for (DemandIterator it(node.DemandBegin()); it != node.DemandEnd(); ++it) {
+					Edge edge = it->second;
+					if (edge.UnsatisfiedDemand() > 0) {
+						Path *path = paths[it->first];
+						assert(path != NULL);
+						/* Generally only allow paths that don't exceed the
+						 * available capacity. But if no demand has been assigned
+						 * yet, make an exception and allow any valid path *once*. */
+						if (path->GetFreeCapacity() > 0 && this->PushFlow(edge, path,
+								accuracy, this->max_saturation) > 0) {
+							/* If a path has been found there is a chance we can
+							 * find more. */
+							more_loops = more_loops || (edge.UnsatisfiedDemand() > 0);
+						} else if (edge.UnsatisfiedDemand() == edge.Demand() &&
+								path->GetFreeCapacity() > INT_MIN) {
+							this->PushFlow(edge, path, accuracy, UINT_MAX);
+						}
 					}
 				}
+				this->CleanupPaths(source, paths);
 			}
-			this->CleanupPaths(source, paths);
 		}
 	} while (more_loops || this->EliminateCycles());
 }
@@ -512,23 +586,33 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 MCF2ndPass::MCF2ndPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
 	this->max_saturation = UINT_MAX; // disable artificial cap on saturation
-	PathVector paths;
+	std::vector<PathVector> batch_paths;
 	uint size = job.Size();
 	uint accuracy = job.Settings().accuracy;
+	uint batch_size = job.Settings().mcf_batch_size;
 	bool demand_left = true;
 	while (demand_left) {
 		demand_left = false;
-		for (NodeID source = 0; source < size; ++source) {
-			this->Dijkstra<CapacityAnnotation, FlowEdgeIterator>(source, paths);
-			for (NodeID dest = 0; dest < size; ++dest) {
-				Edge edge = this->job[source][dest];
-				Path *path = paths[dest];
-				if (edge.UnsatisfiedDemand() > 0 && path->GetFreeCapacity() > INT_MIN) {
-					this->PushFlow(edge, path, accuracy, UINT_MAX);
-					if (edge.UnsatisfiedDemand() > 0) demand_left = true;
+		for (uint first = 0; first < size; first += batch_size) {
+			uint count = min(batch_size, size - first);
+			this->FindPaths<CapacityAnnotation, FlowEdgeIterator>(first, count, batch_paths);
+
+			/* Push the flows in the order of the sources. */
+			for (NodeID source = first; source < first + count; ++source) {
+				PathVector &paths = batch_paths[source - first];
+				if (paths.empty()) continue;
+
+				Node node = this->job[source];
+				for (DemandIterator it(node.DemandBegin()); it != node.DemandEnd(); ++it) {
+					Edge edge = it->second;
+					Path *path = paths[it->first];
+					if (edge.UnsatisfiedDemand() > 0 && path->GetFreeCapacity() > INT_MIN) {
+						this->PushFlow(edge, path, accuracy, UINT_MAX);
+						if (edge.UnsatisfiedDemand() > 0) demand_left = true;
+					}
 				}
+				this->CleanupPaths(source, paths);
 			}
-			this->CleanupPaths(source, paths);
 		}
 	}
 }
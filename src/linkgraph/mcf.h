@@ -21,15 +21,30 @@ protected:
 			max_saturation(job.Settings().short_path_saturation)
 	{}
 
+	/** Path searches from a batch of sources, to be run on the worker pool. */
+	struct PathSearch {
+		MultiCommodityFlow *mcf; ///< Solver to search for.
+		NodeID first;            ///< First source of the batch.
+		const uint *offsets;     ///< Offsets of the sources to search from within the batch.
+		PathVector *paths;       ///< Paths from each source of the batch.
+	};
+
 	template<class Tannotation, class Tedge_iterator>
 	void Dijkstra(NodeID from, PathVector &paths);
 
+	template<class Tannotation, class Tedge_iterator>
+	static void RunPathSearch(void *data, uint begin, uint end);
+
+	template<class Tannotation, class Tedge_iterator>
+	void FindPaths(NodeID first, uint count, std::vector<PathVector> &paths);
+
 	uint PushFlow(Edge &edge, Path *path, uint accuracy, uint max_saturation);
 
 	void CleanupPaths(NodeID source, PathVector &paths);
 
 	LinkGraphJob &job;   ///< Job we're working with.
 	uint max_saturation; ///< Maximum saturation for edges.
+	SmallVector<uint, 16> offsets; ///< Offsets of the sources to search from in the current batch.
 };
 
 /**
@@ -28,6 +28,8 @@
 #include "core/pool_type.hpp"
 #include "game/game.hpp"
 #include "linkgraph/linkgraphschedule.h"
+#include "pathfinder/yapf/yapf_cache.h"
+#include "pathfinder/pf_replay.h"
 
 #include "safeguards.h"
 
@@ -95,6 +97,11 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	InitializeBuildingCounts();
 
 	InitializeNPF();
+	YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+	YapfNotifyRoadLayoutChange(INVALID_TILE);
+	YapfNotifyWaterLayoutChange(INVALID_TILE);
+	/* Queries of another game would not fit the recorded savegame. */
+	PathfinderCaptureStop();
 
 	InitializeCompanies();
 	AI::Initialize();
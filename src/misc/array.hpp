@@ -52,6 +52,14 @@ public:
 		data.Clear();
 	}
 
+	/** Destroy all items, but keep the memory of the first inner array for reuse */
+	inline void Reset()
+	{
+		if (data.IsEmpty()) return;
+		data.Truncate(1);
+		data[0].Clear();
+	}
+
 	/** Return actual number of items */
 	inline uint Length() const
 	{
@@ -87,7 +95,7 @@ public:
 	/** indexed access (non-const) */
 	inline T& operator[](uint index)
 	{
-		const SubArray &s = data[index / B];
+		SubArray &s = data[index / B];
 		T &item = s[index % B];
 		return item;
 	}
@@ -0,0 +1,206 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file dary_heap.hpp Priority queue with integer keys and more than two children per node. */
+
+#ifndef DARY_HEAP_HPP
+#define DARY_HEAP_HPP
+
+#include "../core/alloc_func.hpp"
+#include "../core/math_func.hpp"
+
+/**
+ * Priority queue of pointers to items, ordered by an integer key.
+ *
+ * The key of each item is stored next to the pointer to the item, so
+ * comparing does not need to access the items themselves. Every node
+ * has D children, which makes the tree shallower than a binary heap and
+ * keeps the children of a node within one cache line.
+ *
+ * The order in which items with the same key are returned is unspecified.
+ *
+ * @tparam T Type of the items.
+ * @tparam D Number of children per node.
+ */
+template <class T, uint D = 4>
+class CDaryHeapT {
+private:
+	/** An item with its key. */
+	struct Entry {
+		int key; ///< Key the heap is ordered by.
+		T *item; ///< The item.
+	};
+
+	uint items;    ///< Number of items in the heap.
+	uint capacity; ///< Number of items the heap can hold before it needs to grow.
+	Entry *data;   ///< The entries; the root is at index 0.
+
+	/**
+	 * Move a gap up until an entry can be placed in it.
+	 * @param gap The index of the gap.
+	 * @param entry The entry to place.
+	 * @return The index to place the entry at.
+	 */
+	inline uint SiftUp(uint gap, const Entry &entry)
+	{
+		while (gap > 0) {
+			uint parent = (gap - 1) / D;
+			if (!(entry.key < this->data[parent].key)) break;
+			this->data[gap] = this->data[parent];
+			gap = parent;
+		}
+		return gap;
+	}
+
+	/**
+	 * Move a gap down until an entry can be placed in it.
+	 * @param gap The index of the gap.
+	 * @param entry The entry to place.
+	 * @return The index to place the entry at.
+	 */
+	inline uint SiftDown(uint gap, const Entry &entry)
+	{
+		for (;;) {
+			uint first = gap * D + 1;
+			if (first >= this->items) break;
+
+			/* Find the smallest child. */
+			uint last = min(first + D, this->items);
+			uint child = first;
+			for (uint i = first + 1; i < last; i++) {
+				if (this->data[i].key < this->data[child].key) child = i;
+			}
+
+			if (!(this->data[child].key < entry.key)) break;
+			this->data[gap] = this->data[child];
+			gap = child;
+		}
+		return gap;
+	}
+
+public:
+	/**
+	 * Create an empty heap.
+	 * @param max_items Number of items to allocate space for; the heap grows when it needs more.
+	 */
+	explicit CDaryHeapT(uint max_items) : items(0), capacity(max(max_items, 1U))
+	{
+		this->data = MallocT<Entry>(this->capacity);
+	}
+
+	~CDaryHeapT()
+	{
+		free(this->data);
+	}
+
+	/**
+	 * Get the number of items in the heap.
+	 * @return The number of items.
+	 */
+	inline uint Length() const
+	{
+		return this->items;
+	}
+
+	/**
+	 * Test whether the heap is empty.
+	 * @return True when there are no items.
+	 */
+	inline bool IsEmpty() const
+	{
+		return this->items == 0;
+	}
+
+	/**
+	 * Get the item with the smallest key.
+	 * @return The item; the heap must not be empty.
+	 */
+	inline T *Begin()
+	{
+		assert(!this->IsEmpty());
+		return this->data[0].item;
+	}
+
+	/**
+	 * Insert an item.
+	 * @param item The item.
+	 * @param key The key to order the item by.
+	 */
+	inline void Include(T *item, int key)
+	{
+		if (this->items == this->capacity) {
+			assert(this->capacity < UINT_MAX / 2);
+			this->capacity *= 2;
+			this->data = ReallocT<Entry>(this->data, this->capacity);
+		}
+
+		Entry entry = { key, item };
+		uint gap = this->SiftUp(this->items++, entry);
+		this->data[gap] = entry;
+	}
+
+	/**
+	 * Remove and return the item with the smallest key.
+	 * @return The item; the heap must not be empty.
+	 */
+	inline T *Shift()
+	{
+		assert(!this->IsEmpty());
+
+		T *first = this->data[0].item;
+		this->items--;
+		if (this->items > 0) {
+			Entry last = this->data[this->items];
+			uint gap = this->SiftDown(0, last);
+			this->data[gap] = last;
+		}
+		return first;
+	}
+
+	/**
+	 * Remove the item at a given index.
+	 * @param index The index of the item, as returned by FindIndex().
+	 */
+	inline void Remove(uint index)
+	{
+		assert(index < this->items);
+
+		this->items--;
+		if (index == this->items) return;
+
+		Entry last = this->data[this->items];
+		uint gap = this->SiftUp(index, last);
+		gap = this->SiftDown(gap, last);
+		this->data[gap] = last;
+	}
+
+	/**
+	 * Search for an item by its address.
+	 * @param item The item.
+	 * @return The index of the item, or Length() when it is not in the heap.
+	 */
+	inline uint FindIndex(const T &item) const
+	{
+		for (uint i = 0; i < this->items; i++) {
+			if (this->data[i].item == &item) return i;
+		}
+		return this->items;
+	}
+
+	/**
+	 * Make the heap empty, keeping its memory.
+	 * The items themselves are left untouched.
+	 */
+	inline void Clear()
+	{
+		this->items = 0;
+	}
+};
+
+#endif /* DARY_HEAP_HPP */
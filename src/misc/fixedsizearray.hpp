@@ -110,6 +110,18 @@ public:
 		SizeRef() = 0;
 	}
 
+	/**
+	 * Destroy the items beyond the given number of items.
+	 * @param num_items Number of items to keep.
+	 */
+	inline void Truncate(uint num_items)
+	{
+		for (uint i = this->Length(); i > num_items; i--) {
+			this->data[i - 1].~T();
+		}
+		if (num_items < this->Length()) SizeRef() = num_items;
+	}
+
 	/** return number of used items */
 	inline uint Length() const
 	{
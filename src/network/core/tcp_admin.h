@@ -63,6 +63,8 @@ enum PacketAdminType {
 	ADMIN_PACKET_SERVER_GAMESCRIPT,      ///< The server gives the admin information from the GameScript in JSON.
 	ADMIN_PACKET_SERVER_RCON_END,        ///< The server indicates that the remote console command has completed.
 	ADMIN_PACKET_SERVER_PONG,            ///< The server replies to a ping request from the admin.
+	ADMIN_PACKET_SERVER_TICK_PROFILE,    ///< The server gives the admin the timings of the recent game ticks.
+	ADMIN_PACKET_SERVER_LINKGRAPH_STALLS, ///< The server gives the admin the times the game waited for link graph jobs.
 
 	INVALID_ADMIN_PACKET = 0xFF,         ///< An invalid marker for admin packets.
 };
@@ -86,6 +88,8 @@ enum AdminUpdateType {
 	ADMIN_UPDATE_CMD_NAMES,       ///< The admin would like a list of all DoCommand names.
 	ADMIN_UPDATE_CMD_LOGGING,     ///< The admin would like to have DoCommand information.
 	ADMIN_UPDATE_GAMESCRIPT,      ///< The admin would like to have gamescript messages.
+	ADMIN_UPDATE_TICK_PROFILE,    ///< The admin would like to have the timings of the recent game ticks.
+	ADMIN_UPDATE_LINKGRAPH_STALLS, ///< The admin would like to have the times the game waited for link graph jobs.
 	ADMIN_UPDATE_END,             ///< Must ALWAYS be on the end of this list!! (period)
 };
 
@@ -481,6 +485,37 @@ protected:
 	 */
 	virtual NetworkRecvStatus Receive_SERVER_RCON_END(Packet *p);
 
+	/**
+	 * Send the timings of the recently recorded game ticks; all times are in microseconds:
+	 * uint16  Number of ticks the timings are based on.
+	 * uint8   Number of phases that follow.
+	 * For each phase:
+	 *   uint8   ID of the phase (see #TickProfilerPhase).
+	 *   uint32  Time of the fastest tick.
+	 *   uint32  Average time.
+	 *   uint32  99th percentile of the times.
+	 *   uint32  Time of the slowest tick.
+	 * @param p The packet that was just received.
+	 * @return The state the network should have.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_TICK_PROFILE(Packet *p);
+
+	/**
+	 * Send the times the game waited for link graph jobs that were not done
+	 * when they had to be joined; all times are in microseconds:
+	 * uint8   Number of cargoes that follow.
+	 * For each cargo with joined or postponed jobs:
+	 *   uint8   ID of the cargo.
+	 *   uint32  Number of jobs joined.
+	 *   uint32  Number of joins postponed because the job was not done.
+	 *   uint32  Number of joins the game had to wait for.
+	 *   uint64  Total time the game waited.
+	 *   uint64  Longest time the game waited for a single job.
+	 * @param p The packet that was just received.
+	 * @return The state the network should have.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_LINKGRAPH_STALLS(Packet *p);
+
 	NetworkRecvStatus HandlePacket(Packet *p);
 public:
 	NetworkRecvStatus CloseConnection(bool error = true);
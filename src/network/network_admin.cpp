@@ -24,6 +24,8 @@
 #include "../map_func.h"
 #include "../rev.h"
 #include "../game/game.hpp"
+#include "../tick_profiler.h"
+#include "../linkgraph/linkgraphschedule.h"
 
 #include "../safeguards.h"
 
@@ -56,6 +58,8 @@ static const AdminUpdateFrequency _admin_update_type_frequencies[] = {
 	ADMIN_FREQUENCY_POLL,                                                                                                                                  ///< ADMIN_UPDATE_CMD_NAMES
 	                       ADMIN_FREQUENCY_AUTOMATIC,                                                                                                      ///< ADMIN_UPDATE_CMD_LOGGING
 	                       ADMIN_FREQUENCY_AUTOMATIC,                                                                                                      ///< ADMIN_UPDATE_GAMESCRIPT
+	ADMIN_FREQUENCY_POLL | ADMIN_FREQUENCY_DAILY | ADMIN_FREQUENCY_WEEKLY | ADMIN_FREQUENCY_MONTHLY | ADMIN_FREQUENCY_QUARTERLY | ADMIN_FREQUENCY_ANUALLY, ///< ADMIN_UPDATE_TICK_PROFILE
+	ADMIN_FREQUENCY_POLL | ADMIN_FREQUENCY_DAILY | ADMIN_FREQUENCY_WEEKLY | ADMIN_FREQUENCY_MONTHLY | ADMIN_FREQUENCY_QUARTERLY | ADMIN_FREQUENCY_ANUALLY, ///< ADMIN_UPDATE_LINKGRAPH_STALLS
 };
 /** Sanity check. */
 assert_compile(lengthof(_admin_update_type_frequencies) == ADMIN_UPDATE_END);
@@ -610,6 +614,58 @@ NetworkRecvStatus ServerNetworkAdminSocketHandler::SendPong(uint32 d1)
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+/** Send the timings of the recently recorded game ticks. */
+NetworkRecvStatus ServerNetworkAdminSocketHandler::SendTickProfile()
+{
+	Packet *p = new Packet(ADMIN_PACKET_SERVER_TICK_PROFILE);
+
+	TickProfilerStats stats;
+	GetTickProfilerStats(TPP_BEGIN, &stats);
+	p->Send_uint16(stats.samples);
+	p->Send_uint8(TPP_END);
+
+	for (TickProfilerPhase phase = TPP_BEGIN; phase < TPP_END; phase++) {
+		GetTickProfilerStats(phase, &stats);
+		p->Send_uint8(phase);
+		p->Send_uint32(stats.min);
+		p->Send_uint32(stats.avg);
+		p->Send_uint32(stats.p99);
+		p->Send_uint32(stats.max);
+	}
+
+	this->SendPacket(p);
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
+/** Send the times the game waited for link graph jobs. */
+NetworkRecvStatus ServerNetworkAdminSocketHandler::SendLinkGraphStalls()
+{
+	Packet *p = new Packet(ADMIN_PACKET_SERVER_LINKGRAPH_STALLS);
+
+	uint8 count = 0;
+	for (CargoID c = 0; c < NUM_CARGO; c++) {
+		const LinkGraphJobStats &stats = LinkGraphSchedule::instance.GetStats(c);
+		if (stats.joined != 0 || stats.postponed != 0) count++;
+	}
+	p->Send_uint8(count);
+
+	for (CargoID c = 0; c < NUM_CARGO; c++) {
+		const LinkGraphJobStats &stats = LinkGraphSchedule::instance.GetStats(c);
+		if (stats.joined == 0 && stats.postponed == 0) continue;
+		p->Send_uint8(c);
+		p->Send_uint32(stats.joined);
+		p->Send_uint32(stats.postponed);
+		p->Send_uint32(stats.stalls);
+		p->Send_uint64(stats.stall_time);
+		p->Send_uint64(stats.max_stall_time);
+	}
+
+	this->SendPacket(p);
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 /** Send the names of the commands. */
 NetworkRecvStatus ServerNetworkAdminSocketHandler::SendCmdNames()
 {
@@ -732,6 +788,16 @@ NetworkRecvStatus ServerNetworkAdminSocketHandler::Receive_ADMIN_POLL(Packet *p)
 			this->SendDate();
 			break;
 
+		case ADMIN_UPDATE_TICK_PROFILE:
+			/* The admin is requesting the timings of the recent ticks. */
+			this->SendTickProfile();
+			break;
+
+		case ADMIN_UPDATE_LINKGRAPH_STALLS:
+			/* The admin is requesting the times the game waited for link graph jobs. */
+			this->SendLinkGraphStalls();
+			break;
+
 		case ADMIN_UPDATE_CLIENT_INFO:
 			/* The admin is requesting client info. */
 			const NetworkClientSocket *cs;
@@ -1039,6 +1105,14 @@ void NetworkAdminUpdate(AdminUpdateFrequency freq)
 						as->SendCompanyStats();
 						break;
 
+					case ADMIN_UPDATE_TICK_PROFILE:
+						as->SendTickProfile();
+						break;
+
+					case ADMIN_UPDATE_LINKGRAPH_STALLS:
+						as->SendLinkGraphStalls();
+						break;
+
 					default: NOT_REACHED();
 				}
 			}
@@ -72,6 +72,8 @@ public:
 	NetworkRecvStatus SendCmdNames();
 	NetworkRecvStatus SendCmdLogging(ClientID client_id, const CommandPacket *cp);
 	NetworkRecvStatus SendRconEnd(const char *command);
+	NetworkRecvStatus SendTickProfile();
+	NetworkRecvStatus SendLinkGraphStalls();
 
 	static void Send();
 	static void AcceptConnection(SOCKET s, const NetworkAddress &address);
@@ -65,6 +65,7 @@
 #include "viewport_sprite_sorter.h"
 
 #include "linkgraph/linkgraphschedule.h"
+#include "tick_profiler.h"
 
 #include <stdarg.h>
 
@@ -302,6 +303,7 @@ static void ShutdownGame()
 #endif
 
 	LinkGraphSchedule::Clear();
+	LinkGraphSchedule::UninitializeWorkers();
 	PoolBase::Clean(PT_ALL);
 
 	/* No NewGRFs were loaded when it was still bootstrapping. */
@@ -1338,6 +1340,27 @@ static void CheckCaches()
 	}
 }
 
+/** Run the tile loop while measuring the time it takes. */
+static void RunProfiledTileLoop()
+{
+	TickProfilerScope profile(TPP_TILE_LOOP);
+	RunTileLoop();
+}
+
+/** Run the vehicle ticks while measuring the time they take. */
+static void RunProfiledVehicleTicks()
+{
+	TickProfilerScope profile(TPP_VEHICLE_TICKS);
+	CallVehicleTicks();
+}
+
+/** Run the landscape tick while measuring the time it takes. */
+static void RunProfiledLandscapeTick()
+{
+	TickProfilerScope profile(TPP_LANDSCAPE_TICK);
+	CallLandscapeTick();
+}
+
 /**
  * State controlling game loop.
  * The state must not be changed from anywhere but here.
@@ -1358,11 +1381,13 @@ void StateGameLoop()
 
 	Layouter::ReduceLineCache();
 
+	TickProfilerTick profile_tick;
+
 	if (_game_mode == GM_EDITOR) {
 		BasePersistentStorageArray::SwitchMode(PSM_ENTER_GAMELOOP);
-		RunTileLoop();
-		CallVehicleTicks();
-		CallLandscapeTick();
+		RunProfiledTileLoop();
+		RunProfiledVehicleTicks();
+		RunProfiledLandscapeTick();
 		BasePersistentStorageArray::SwitchMode(PSM_LEAVE_GAMELOOP);
 		UpdateLandscapingLimits();
 
@@ -1385,14 +1410,20 @@ void StateGameLoop()
 		BasePersistentStorageArray::SwitchMode(PSM_ENTER_GAMELOOP);
 		AnimateAnimatedTiles();
 		IncreaseDate();
-		RunTileLoop();
-		CallVehicleTicks();
-		CallLandscapeTick();
+		RunProfiledTileLoop();
+		RunProfiledVehicleTicks();
+		RunProfiledLandscapeTick();
 		BasePersistentStorageArray::SwitchMode(PSM_LEAVE_GAMELOOP);
 
 #ifndef DEBUG_DUMP_COMMANDS
-		AI::GameLoop();
-		Game::GameLoop();
+		{
+			TickProfilerScope profile(TPP_AI_GAME_LOOP);
+			AI::GameLoop();
+		}
+		{
+			TickProfilerScope profile(TPP_GS_GAME_LOOP);
+			Game::GameLoop();
+		}
 #endif
 		UpdateLandscapingLimits();
 
@@ -0,0 +1,328 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file depot_distance.hpp Tables of the distance from track pieces to the nearest depot. */
+
+#ifndef DEPOT_DISTANCE_HPP
+#define DEPOT_DISTANCE_HPP
+
+#include "../rail_map.h"
+#include "../road_map.h"
+#include "../tunnelbridge_map.h"
+#include "../depot_base.h"
+#include "../core/smallvec_type.hpp"
+#include "pathfinder_type.h"
+#include "follow_track.hpp"
+
+#include <map>
+#include <queue>
+#include <functional>
+
+/**
+ * The distances from all track pieces near a set of depots to the nearest of
+ * those depots, found by one search from all depots at once that follows the
+ * tracks backwards. Looking up the nearest depot of a vehicle is then a table
+ * read instead of a path search.
+ *
+ * The distance is the length of the track only, measured like the base cost
+ * of YAPF, so it never exceeds the cost YAPF finds for the same path. Track
+ * pieces that are further away from every depot than the limit of the table
+ * are not in the table.
+ *
+ * @tparam Tfollow The track follower to search with; it determines the transport type and whether 90 degree turns are allowed.
+ */
+template <class Tfollow>
+class CDepotDistanceT {
+	/** Distance of a track piece to its nearest depot. */
+	struct Entry {
+		TileIndex depot; ///< The nearest depot.
+		uint cost;       ///< Length of the track to the depot.
+	};
+
+	typedef std::map<uint32, Entry> EntryMap;
+	typedef std::pair<uint, uint32> OpenItem;
+
+	Owner owner;     ///< Owner of the depots.
+	uint types;      ///< Rail or road types the table is made for.
+	uint limit;      ///< Maximum distance stored in the table.
+	EntryMap entries; ///< Distance of each track piece near a depot, indexed by GetKey().
+
+	/**
+	 * Get the key of a track piece in the table.
+	 * @param tile The tile of the track piece.
+	 * @param td The direction the track piece is travelled in.
+	 * @return The key.
+	 */
+	static inline uint32 GetKey(TileIndex tile, Trackdir td)
+	{
+		return tile << 4 | td;
+	}
+
+	/**
+	 * Check whether a tile has track pieces in the table.
+	 * @param tile The tile to check.
+	 * @return True when the table knows the distance of a track piece on the tile.
+	 */
+	inline bool HasTile(TileIndex tile) const
+	{
+		typename EntryMap::const_iterator it = this->entries.lower_bound(GetKey(tile, (Trackdir)0));
+		return it != this->entries.end() && (it->first >> 4) == tile;
+	}
+
+	/**
+	 * Add the track pieces from which a track piece is reached directly.
+	 * @param ft Follower to use.
+	 * @param open Queue of track pieces to continue the search from.
+	 * @param tile The tile of the reached track piece.
+	 * @param td The trackdir of the reached track piece.
+	 * @param cost Distance from the reached track piece to the depot.
+	 * @param depot The depot.
+	 * @param from Candidate tile to come from.
+	 * @param exitdir The side \a from has to be left through to reach \a tile.
+	 */
+	void AddPredecessors(Tfollow &ft, std::priority_queue<OpenItem, std::vector<OpenItem>, std::greater<OpenItem> > &open, TileIndex tile, Trackdir td, uint cost, TileIndex depot, TileIndex from, DiagDirection exitdir)
+	{
+		TrackdirBits candidates = TrackStatusToTrackdirBits(GetTileTrackStatus(from, Tfollow::TT(), Tfollow::IsRoadTT() ? this->types : 0));
+		while (candidates != TRACKDIR_BIT_NONE) {
+			Trackdir from_td = RemoveFirstTrackdir(&candidates);
+			if (exitdir != INVALID_DIAGDIR && TrackdirToExitdir(from_td) != exitdir) continue;
+			/* Trains can not pass one way signals from the back. */
+			if (Tfollow::IsRailTT() && HasOnewaySignalBlockingTrackdir(from, from_td)) continue;
+
+			/* Only the follower knows whether the track pieces really connect. */
+			if (!ft.Follow(from, from_td) || ft.m_new_tile != tile || (ft.m_new_td_bits & TrackdirToTrackdirBits(td)) == 0) continue;
+
+			uint from_cost = cost + (IsDiagonalTrackdir(from_td) ? YAPF_TILE_LENGTH : YAPF_TILE_CORNER_LENGTH) * (ft.m_tiles_skipped + 1);
+			if (from_cost > this->limit) continue;
+
+			uint32 key = GetKey(from, from_td);
+			typename EntryMap::iterator it = this->entries.find(key);
+			if (it != this->entries.end() && it->second.cost <= from_cost) continue;
+
+			Entry &entry = this->entries[key];
+			entry.depot = depot;
+			entry.cost = from_cost;
+			open.push(OpenItem(from_cost, key));
+		}
+	}
+
+public:
+	/**
+	 * Create an empty table.
+	 * @param owner Owner of the depots and the vehicles.
+	 * @param types The rail or road types the vehicles can use.
+	 * @param limit Maximum distance to store.
+	 */
+	CDepotDistanceT(Owner owner, uint types, uint limit) : owner(owner), types(types), limit(limit)
+	{
+	}
+
+	/**
+	 * Check whether the table answers the questions of a vehicle.
+	 * @param owner Owner of the vehicle.
+	 * @param types The rail or road types the vehicle can use.
+	 * @param limit Maximum distance the vehicle is interested in.
+	 * @return True when the table is made for these parameters.
+	 */
+	inline bool Matches(Owner owner, uint types, uint limit) const
+	{
+		return this->owner == owner && this->types == types && this->limit == limit;
+	}
+
+	/**
+	 * Fill the table by searching from all depots at once.
+	 * @param ft Follower for the vehicles of the table.
+	 * @param depots The depots of the owner that the vehicles can enter.
+	 * @param num_depots Number of depots.
+	 */
+	void Build(Tfollow &ft, const TileIndex *depots, uint num_depots)
+	{
+		std::priority_queue<OpenItem, std::vector<OpenItem>, std::greater<OpenItem> > open;
+
+		this->entries.clear();
+		for (uint i = 0; i < num_depots; i++) {
+			DiagDirection dir = Tfollow::IsRailTT() ? GetRailDepotDirection(depots[i]) : GetRoadDepotDirection(depots[i]);
+			uint32 key = GetKey(depots[i], DiagDirToDiagTrackdir(ReverseDiagDir(dir)));
+
+			Entry &entry = this->entries[key];
+			entry.depot = depots[i];
+			entry.cost = 0;
+			open.push(OpenItem(0, key));
+		}
+
+		while (!open.empty()) {
+			OpenItem item = open.top();
+			open.pop();
+
+			const Entry &entry = this->entries[item.second];
+			if (entry.cost != item.first) continue; // A shorter path was found already.
+			TileIndex depot = entry.depot;
+
+			TileIndex tile = item.second >> 4;
+			Trackdir td = (Trackdir)GB(item.second, 0, 4);
+
+			/* The track piece is reached from the neighbouring tiles, or from the other end of a tunnel or bridge. */
+			for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+				TileIndex from = AddTileIndexDiffCWrap(tile, TileIndexDiffCByDiagDir(ReverseDiagDir(dir)));
+				if (from != INVALID_TILE) this->AddPredecessors(ft, open, tile, td, item.first, depot, from, dir);
+			}
+			if (IsTileType(tile, MP_TUNNELBRIDGE)) {
+				TileIndex from = GetOtherTunnelBridgeEnd(tile);
+				this->AddPredecessors(ft, open, tile, td, item.first, depot, from, ReverseDiagDir(GetTunnelBridgeDirection(tile)));
+			}
+			/* Road vehicles turn around at the end of the road. */
+			if (Tfollow::IsRoadTT()) this->AddPredecessors(ft, open, tile, td, item.first, depot, tile, INVALID_DIAGDIR);
+		}
+	}
+
+	/**
+	 * Look up the nearest depot of a track piece.
+	 * @param tile The tile the vehicle is on.
+	 * @param td The trackdir the vehicle is on.
+	 * @return The nearest depot and its distance, or no depot when all depots are further away than the limit.
+	 */
+	FindDepotData Find(TileIndex tile, Trackdir td) const
+	{
+		typename EntryMap::const_iterator it = this->entries.find(GetKey(tile, td));
+		if (it == this->entries.end()) return FindDepotData();
+		return FindDepotData(it->second.depot, it->second.cost);
+	}
+
+	/**
+	 * Check whether a change of the network at a tile might change the table.
+	 * @param tile The changed tile.
+	 * @return True when the tile touches the part of the network in the table.
+	 */
+	bool IsAffectedBy(TileIndex tile) const
+	{
+		if (this->HasTile(tile)) return true;
+		for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+			TileIndex neighbour = AddTileIndexDiffCWrap(tile, TileIndexDiffCByDiagDir(dir));
+			if (neighbour != INVALID_TILE && this->HasTile(neighbour)) return true;
+		}
+		return false;
+	}
+};
+
+/**
+ * The depot distance tables of all owners and vehicle types of a transport type.
+ * @tparam Tfollow The track follower of the tables.
+ */
+template <class Tfollow>
+class CDepotDistanceCacheT {
+	typedef CDepotDistanceT<Tfollow> Table;
+
+	SmallVector<Table *, 8> tables; ///< The tables built so far.
+
+	/**
+	 * Check whether vehicles can use a depot.
+	 * @param tile The tile of the depot.
+	 * @param owner Owner of the vehicles.
+	 * @param types The rail or road types the vehicles can use.
+	 * @return True when the depot belongs to the table of the vehicles.
+	 */
+	static bool IsUsableDepot(TileIndex tile, Owner owner, uint types)
+	{
+		if (!IsTileOwner(tile, owner)) return false;
+		if (Tfollow::IsRailTT()) return IsRailDepotTile(tile) && HasBit(types, GetRailType(tile));
+		return IsRoadDepotTile(tile) && (GetRoadTypes(tile) & types) != 0;
+	}
+
+public:
+	~CDepotDistanceCacheT()
+	{
+		this->Clear();
+	}
+
+	/**
+	 * Look up the nearest depot of a vehicle, building the table of its owner and types when needed.
+	 * @param ft Follower for the vehicle; only its owner and types may matter.
+	 * @param owner Owner of the vehicle.
+	 * @param types The rail or road types the vehicle can use.
+	 * @param limit Maximum distance the vehicle is interested in.
+	 * @param tile The tile the vehicle is on.
+	 * @param td The trackdir the vehicle is on.
+	 * @return The nearest depot and its distance, or no depot when all depots are further away than \a limit.
+	 */
+	FindDepotData FindNearestDepot(Tfollow &ft, Owner owner, uint types, uint limit, TileIndex tile, Trackdir td)
+	{
+		Table *table = this->Get(owner, types, limit);
+		if (table == NULL) {
+			SmallVector<TileIndex, 32> depots;
+			const Depot *depot;
+			FOR_ALL_DEPOTS(depot) {
+				if (IsUsableDepot(depot->xy, owner, types)) *depots.Append() = depot->xy;
+			}
+
+			table = this->Add(owner, types, limit);
+			table->Build(ft, depots.Begin(), depots.Length());
+		}
+		return table->Find(tile, td);
+	}
+
+	/**
+	 * Get the table for some vehicles.
+	 * @param owner Owner of the vehicles.
+	 * @param types The rail or road types the vehicles can use.
+	 * @param limit Maximum distance the vehicles are interested in.
+	 * @return The table, or NULL when it has to be built first.
+	 */
+	Table *Get(Owner owner, uint types, uint limit)
+	{
+		for (Table **t = this->tables.Begin(); t != this->tables.End(); t++) {
+			if ((*t)->Matches(owner, types, limit)) return *t;
+		}
+		return NULL;
+	}
+
+	/**
+	 * Add a table for some vehicles; it still has to be built.
+	 * @param owner Owner of the vehicles.
+	 * @param types The rail or road types the vehicles can use.
+	 * @param limit Maximum distance the vehicles are interested in.
+	 * @return The new table.
+	 */
+	Table *Add(Owner owner, uint types, uint limit)
+	{
+		Table *t = new Table(owner, types, limit);
+		*this->tables.Append() = t;
+		return t;
+	}
+
+	/**
+	 * Forget the tables a change of the network might affect.
+	 * @param tile The changed tile, or INVALID_TILE to forget all tables.
+	 * @param new_depot Whether a depot was built at the tile; a new depot can be the nearest one anywhere.
+	 */
+	void Invalidate(TileIndex tile, bool new_depot)
+	{
+		if (tile == INVALID_TILE || new_depot) {
+			this->Clear();
+			return;
+		}
+
+		for (uint i = 0; i < this->tables.Length();) {
+			if (this->tables[i]->IsAffectedBy(tile)) {
+				delete this->tables[i];
+				this->tables.ErasePreservingOrder(i);
+			} else {
+				i++;
+			}
+		}
+	}
+
+	/** Forget all tables. */
+	void Clear()
+	{
+		for (Table **t = this->tables.Begin(); t != this->tables.End(); t++) delete *t;
+		this->tables.Clear();
+	}
+};
+
+#endif /* DEPOT_DISTANCE_HPP */
@@ -26,6 +26,7 @@
 #include "../../stdafx.h"
 #include "../../core/alloc_func.hpp"
 #include "aystar.h"
+#include "../pf_replay.h"
 
 #include "../../safeguards.h"
 
@@ -47,7 +48,7 @@ PathNode *AyStar::ClosedListIsInList(const AyStarNode *node)
 void AyStar::ClosedListAdd(const PathNode *node)
 {
 	/* Add a node to the ClosedList */
-	PathNode *new_node = MallocT<PathNode>(1);
+	PathNode *new_node = (PathNode*)this->closedlist_nodes.Alloc();
 	*new_node = *node;
 	this->closedlist_hash.Set(node->node.tile, node->node.direction, new_node);
 }
@@ -85,7 +86,7 @@ OpenListNode *AyStar::OpenListPop()
 void AyStar::OpenListAdd(PathNode *parent, const AyStarNode *node, int f, int g)
 {
 	/* Add a new Node to the OpenList */
-	OpenListNode *new_node = MallocT<OpenListNode>(1);
+	OpenListNode *new_node = (OpenListNode*)this->openlist_nodes.Alloc();
 	new_node->g = g;
 	new_node->path.parent = parent;
 	new_node->path.node = *node;
@@ -168,13 +169,13 @@ int AyStar::Loop()
 	OpenListNode *current = this->OpenListPop();
 	/* If empty, drop an error */
 	if (current == NULL) return AYSTAR_EMPTY_OPENLIST;
+	_pf_nodes_expanded++;
 
 	/* Check for end node and if found, return that code */
 	if (this->EndNodeCheck(this, current) == AYSTAR_FOUND_END_NODE) {
 		if (this->FoundEndNode != NULL) {
 			this->FoundEndNode(this, current);
 		}
-		free(current);
 		return AYSTAR_FOUND_END_NODE;
 	}
 
@@ -190,8 +191,7 @@ int AyStar::Loop()
 		this->CheckTile(&this->neighbours[i], current);
 	}
 
-	/* Free the node */
-	free(current);
+	/* The node itself stays in openlist_nodes until the next Clear() */
 
 	if (this->max_search_nodes != 0 && this->closedlist_hash.GetSize() >= this->max_search_nodes) {
 		/* We've expanded enough nodes */
@@ -208,10 +208,11 @@ int AyStar::Loop()
 void AyStar::Free()
 {
 	this->openlist_queue.Free(false);
-	/* 2nd argument above is false, below is true, to free the values only
-	 * once */
-	this->openlist_hash.Delete(true);
-	this->closedlist_hash.Delete(true);
+	/* The values of the hashes are in the arenas */
+	this->openlist_hash.Delete(false);
+	this->closedlist_hash.Delete(false);
+	this->openlist_nodes.Free();
+	this->closedlist_nodes.Free();
 #ifdef AYSTAR_DEBUG
 	printf("[AyStar] Memory free'd\n");
 #endif
@@ -223,12 +224,13 @@ void AyStar::Free()
  */
 void AyStar::Clear()
 {
-	/* Clean the Queue, but not the elements within. That will be done by
-	 * the hash. */
+	/* Clean the Queue and the hashes, but not the nodes within. Those are
+	 * released all at once by the arenas, which keep their memory. */
 	this->openlist_queue.Clear(false);
-	/* Clean the hashes */
-	this->openlist_hash.Clear(true);
-	this->closedlist_hash.Clear(true);
+	this->openlist_hash.Clear(false);
+	this->closedlist_hash.Clear(false);
+	this->openlist_nodes.Clear();
+	this->closedlist_nodes.Clear();
 
 #ifdef AYSTAR_DEBUG
 	printf("[AyStar] Cleared AyStar\n");
@@ -298,6 +300,9 @@ void AyStar::Init(Hash_HashProc hash, uint num_buckets)
 	this->openlist_hash.Init(hash, num_buckets);
 	this->closedlist_hash.Init(hash, num_buckets);
 
+	this->openlist_nodes.Init(sizeof(OpenListNode));
+	this->closedlist_nodes.Init(sizeof(PathNode));
+
 	/* Set up our sorting queue
 	 *  BinaryHeap allocates a block of 1024 nodes
 	 *  When that one gets full it reserves another one, till this number
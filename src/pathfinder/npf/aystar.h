@@ -156,9 +156,11 @@ struct AyStar {
 	void CheckTile(AyStarNode *current, OpenListNode *parent);
 
 protected:
-	Hash       closedlist_hash; ///< The actual closed list.
-	BinaryHeap openlist_queue;  ///< The open queue.
-	Hash       openlist_hash;   ///< An extra hash to speed up the process of looking up an element in the open list.
+	Hash       closedlist_hash;  ///< The actual closed list.
+	BinaryHeap openlist_queue;   ///< The open queue.
+	Hash       openlist_hash;    ///< An extra hash to speed up the process of looking up an element in the open list.
+	NodeArena  closedlist_nodes; ///< Storage of the nodes in the closed list.
+	NodeArena  openlist_nodes;   ///< Storage of the nodes in the open list.
 
 	void OpenListAdd(PathNode *parent, const AyStarNode *node, int f, int g);
 	OpenListNode *OpenListIsInList(const AyStarNode *node);
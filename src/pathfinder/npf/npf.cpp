@@ -637,6 +637,7 @@ static void NPFSaveTargetData(AyStar *as, OpenListNode *current)
 			if (!IsWaitingPositionFree(v, end_tile, target->node.direction, _settings_game.pf.forbid_90_deg)) return;
 			SetRailStationPlatformReservation(target->node.tile, dir, true);
 			SetRailStationReservation(target->node.tile, false);
+			MarkReservationsChanged();
 		} else {
 			if (!IsWaitingPositionFree(v, target->node.tile, target->node.direction, _settings_game.pf.forbid_90_deg)) return;
 		}
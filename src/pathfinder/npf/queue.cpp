@@ -7,7 +7,7 @@
  * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
  */
 
-/** @file queue.cpp Implementation of the #BinaryHeap/#Hash. */
+/** @file queue.cpp Implementation of the #BinaryHeap/#NodeArena/#Hash. */
 
 #include "../../stdafx.h"
 #include "../../core/alloc_func.hpp"
@@ -223,6 +223,49 @@ void BinaryHeap::Init(uint max_size)
 /* Because we don't want anyone else to bother with our defines */
 #undef BIN_HEAP_ARR
 
+/*
+ * Node arena
+ */
+
+/**
+ * Initializes an arena for items of the given size. No memory is
+ * allocated until the first item is requested.
+ */
+void NodeArena::Init(size_t item_size)
+{
+	this->item_size = item_size;
+	this->used = 0;
+	this->num_blocks = 0;
+	this->blocks = NULL;
+}
+
+/** Allocates the block for the next items. */
+void NodeArena::AddBlock()
+{
+	this->blocks = ReallocT<byte*>(this->blocks, this->num_blocks + 1);
+	this->blocks[this->num_blocks++] = MallocT<byte>(this->item_size << BLOCK_SIZE_BITS);
+}
+
+/**
+ * Releases all items at once. The memory of the blocks is kept, so
+ * the next items do not need new allocations.
+ */
+void NodeArena::Clear()
+{
+	this->used = 0;
+}
+
+/**
+ * Frees the arena, by reclaiming all memory allocated by it. It can be
+ * used again after Init().
+ */
+void NodeArena::Free()
+{
+	for (uint i = 0; i < this->num_blocks; i++) free(this->blocks[i]);
+	free(this->blocks);
+	this->Init(this->item_size);
+}
+
 /*
  * Hash
  */
@@ -245,6 +288,8 @@ void Hash::Init(Hash_HashProc *hash, uint num_buckets)
 	this->buckets = (HashNode*)MallocT<byte>(num_buckets * (sizeof(*this->buckets) + sizeof(*this->buckets_in_use)));
 	this->buckets_in_use = (bool*)(this->buckets + num_buckets);
 	for (i = 0; i < num_buckets; i++) this->buckets_in_use[i] = false;
+	this->node_arena.Init(sizeof(HashNode));
+	this->free_nodes = NULL;
 }
 
 /**
@@ -254,27 +299,10 @@ void Hash::Init(Hash_HashProc *hash, uint num_buckets)
  */
 void Hash::Delete(bool free_values)
 {
-	uint i;
-
-	/* Iterate all buckets */
-	for (i = 0; i < this->num_buckets; i++) {
-		if (this->buckets_in_use[i]) {
-			HashNode *node;
-
-			/* Free the first value */
-			if (free_values) free(this->buckets[i].value);
-			node = this->buckets[i].next;
-			while (node != NULL) {
-				HashNode *prev = node;
-
-				node = node->next;
-				/* Free the value */
-				if (free_values) free(prev->value);
-				/* Free the node */
-				free(prev);
-			}
-		}
-	}
+	/* Free the values; the nodes are freed with the arena */
+	if (free_values) this->FreeValues();
+	this->node_arena.Free();
+	this->free_nodes = NULL;
 	free(this->buckets);
 	/* No need to free buckets_in_use, it is always allocated in one
 	 * malloc with buckets */
@@ -331,35 +359,52 @@ void Hash::PrintStatistics() const
 }
 #endif
 
+/**
+ * Calls free() on all values in the hash.
+ */
+void Hash::FreeValues()
+{
+	for (uint i = 0; i < this->num_buckets; i++) {
+		if (!this->buckets_in_use[i]) continue;
+		for (const HashNode *node = &this->buckets[i]; node != NULL; node = node->next) free(node->value);
+	}
+}
+
+/**
+ * Gets a node to store a key pair that does not fit in its bucket.
+ * Nodes deleted earlier are used again before new ones are taken from the arena.
+ */
+HashNode *Hash::AllocNode()
+{
+	HashNode *node = this->free_nodes;
+	if (node == NULL) return (HashNode*)this->node_arena.Alloc();
+	this->free_nodes = node->next;
+	return node;
+}
+
+/**
+ * Gives back a node that is no longer in any bucket.
+ */
+void Hash::ReleaseNode(HashNode *node)
+{
+	node->next = this->free_nodes;
+	this->free_nodes = node;
+}
+
 /**
  * Cleans the hash, but keeps the memory allocated
  */
 void Hash::Clear(bool free_values)
 {
-	uint i;
-
 #ifdef HASH_STATS
 	if (this->size > 2000) this->PrintStatistics();
 #endif
 
-	/* Iterate all buckets */
-	for (i = 0; i < this->num_buckets; i++) {
-		if (this->buckets_in_use[i]) {
-			HashNode *node;
-
-			this->buckets_in_use[i] = false;
-			/* Free the first value */
-			if (free_values) free(this->buckets[i].value);
-			node = this->buckets[i].next;
-			while (node != NULL) {
-				HashNode *prev = node;
-
-				node = node->next;
-				if (free_values) free(prev->value);
-				free(prev);
-			}
-		}
-	}
+	if (free_values) this->FreeValues();
+	/* All nodes outside the buckets are given back at once */
+	memset(this->buckets_in_use, 0, this->num_buckets * sizeof(*this->buckets_in_use));
+	this->node_arena.Clear();
+	this->free_nodes = NULL;
 	this->size = 0;
 }
 
@@ -427,7 +472,7 @@ void *Hash::DeleteValue(uint key1, uint key2)
 			/* Copy the second to the first */
 			*node = *next;
 			/* Free the second */
-			free(next);
+			this->ReleaseNode(next);
 		} else {
 			/* This was the last in this bucket
 			 * Mark it as empty */
@@ -441,7 +486,7 @@ void *Hash::DeleteValue(uint key1, uint key2)
 		/* Link previous and next nodes */
 		prev->next = node->next;
 		/* Free the node */
-		free(node);
+		this->ReleaseNode(node);
 	}
 	if (result != NULL) this->size--;
 	return result;
@@ -471,7 +516,7 @@ void *Hash::Set(uint key1, uint key2, void *value)
 		node = this->buckets + hash;
 	} else {
 		/* Add it after prev */
-		node = MallocT<HashNode>(1);
+		node = this->AllocNode();
 		prev->next = node;
 	}
 	node->next = NULL;
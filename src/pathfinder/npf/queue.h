@@ -7,7 +7,7 @@
  * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
  */
 
-/** @file queue.h Binary heap implementation, hash implementation. */
+/** @file queue.h Binary heap implementation, node arena implementation, hash implementation. */
 
 #ifndef QUEUE_H
 #define QUEUE_H
@@ -56,6 +56,41 @@ struct BinaryHeap {
 };
 
 
+/**
+ * Storage for items of a fixed size that are released all at once.
+ * Items are allocated in blocks, so their addresses stay valid until the
+ * arena is cleared. The blocks are kept for reuse after clearing.
+ */
+struct NodeArena {
+	static const uint BLOCK_SIZE_BITS = 10; ///< Log2 of the number of items per block.
+	static const uint BLOCK_SIZE_MASK = (1 << BLOCK_SIZE_BITS) - 1;
+
+	void Init(size_t item_size);
+
+	/**
+	 * Get memory for a new item.
+	 * @return The uninitialised item.
+	 */
+	inline void *Alloc()
+	{
+		uint block = this->used >> BLOCK_SIZE_BITS;
+		if (block == this->num_blocks) this->AddBlock();
+		return this->blocks[block] + (this->used++ & BLOCK_SIZE_MASK) * this->item_size;
+	}
+
+	void Clear();
+	void Free();
+
+	size_t item_size; ///< Size of an item in bytes.
+	uint used;        ///< Number of items handed out since the last clear.
+	uint num_blocks;  ///< Number of allocated blocks.
+	byte **blocks;    ///< The allocated blocks.
+
+protected:
+	void AddBlock();
+};
+
+
 /*
  * Hash
  */
@@ -82,6 +117,10 @@ struct Hash {
 	/* A pointer to an array of numbuckets booleans, which will be true if
 	 * there are any Nodes in the bucket */
 	bool *buckets_in_use;
+	/* Storage of the nodes that do not fit in the buckets */
+	NodeArena node_arena;
+	/* Nodes from node_arena that were deleted and can be used again */
+	HashNode *free_nodes;
 
 	void Init(Hash_HashProc *hash, uint num_buckets);
 
@@ -106,6 +145,9 @@ protected:
 	void PrintStatistics() const;
 #endif
 	HashNode *FindNode(uint key1, uint key2, HashNode** prev_out) const;
+	void FreeValues();
+	HashNode *AllocNode();
+	void ReleaseNode(HashNode *node);
 };
 
 #endif /* QUEUE_H */
@@ -14,6 +14,7 @@
 #include "../../tunnelbridge.h"
 #include "../../ship.h"
 #include "../../core/random_func.hpp"
+#include "../pf_replay.h"
 
 #include "../../safeguards.h"
 
@@ -52,6 +53,8 @@ static bool ShipTrackFollower(TileIndex tile, TrackPathFinder *pfs, uint length)
 
 static void TPFModeShip(TrackPathFinder *tpf, TileIndex tile, DiagDirection direction)
 {
+	_pf_nodes_expanded++;
+
 	if (IsTileType(tile, MP_TUNNELBRIDGE)) {
 		/* wrong track type */
 		if (GetTunnelBridgeTransportType(tile) != TRANSPORT_WATER) return;
@@ -0,0 +1,315 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file path_regions.cpp Implementation of the coarse connectivity of transport networks. */
+
+#include "../stdafx.h"
+#include "../tunnelbridge_map.h"
+#include "../tunnelbridge.h"
+#include "path_regions.h"
+
+#include <map>
+#include <queue>
+#include <functional>
+
+#include "../safeguards.h"
+
+/** Search state of a patch during PathRegionMap::FindPath. */
+struct PathRegionNode {
+	uint cost;     ///< Cost of the best path to the patch found so far.
+	uint32 parent; ///< Key of the patch this one is reached from.
+	bool closed;   ///< Whether the best path to the patch is known.
+};
+
+/**
+ * Get the key of a patch for the search.
+ * @param patch The patch.
+ * @return Unique number of the patch.
+ */
+static inline uint32 GetPatchKey(const PathRegionPatch &patch)
+{
+	return patch.region << 8 | patch.patch;
+}
+
+/**
+ * Get the patch belonging to a search key.
+ * @param key The key of the patch.
+ * @return The patch.
+ */
+static inline PathRegionPatch GetKeyPatch(uint32 key)
+{
+	PathRegionPatch patch;
+	patch.region = key >> 8;
+	patch.patch = GB(key, 0, 8);
+	return patch;
+}
+
+/**
+ * Create a map for a network; nothing is analysed until it is used.
+ * @param get_sides Function telling which sides of a tile are connected.
+ * @param param Parameter to pass to \a get_sides.
+ */
+PathRegionMap::PathRegionMap(PathRegionSidesProc *get_sides, uint param) : get_sides(get_sides), param(param), regions(NULL), size_x(0), size_y(0)
+{
+}
+
+PathRegionMap::~PathRegionMap()
+{
+	delete[] this->regions;
+}
+
+/** Make sure there are regions for the current map size. */
+void PathRegionMap::Allocate()
+{
+	uint size_x = MapSizeX() >> PATH_REGION_BITS;
+	uint size_y = MapSizeY() >> PATH_REGION_BITS;
+	if (this->regions != NULL && this->size_x == size_x && this->size_y == size_y) return;
+
+	delete[] this->regions;
+	this->size_x = size_x;
+	this->size_y = size_y;
+	this->regions = new Region[size_x * size_y];
+	for (uint i = 0; i < size_x * size_y; i++) this->regions[i].valid = false;
+}
+
+/**
+ * Mark the region of a tile for analysis after the network changed at the tile.
+ * @param tile The changed tile.
+ */
+void PathRegionMap::Invalidate(TileIndex tile)
+{
+	if (this->regions == NULL) return;
+	this->regions[this->GetRegionIndex(tile)].valid = false;
+}
+
+/** Forget everything about the network, e.g. after loading a game. */
+void PathRegionMap::InvalidateAll()
+{
+	delete[] this->regions;
+	this->regions = NULL;
+}
+
+/**
+ * Get the tile the network continues to from a tile.
+ * @param tile The tile to leave.
+ * @param dir The side of the tile to leave it through.
+ * @return The reached tile, or INVALID_TILE when leaving the map.
+ */
+TileIndex PathRegionMap::GetNeighbour(TileIndex tile, DiagDirection dir) const
+{
+	if (IsTileType(tile, MP_TUNNELBRIDGE) && GetTunnelBridgeDirection(tile) == dir) return GetOtherTunnelBridgeEnd(tile);
+	return AddTileIndexDiffCWrap(tile, TileIndexDiffCByDiagDir(dir));
+}
+
+/**
+ * Split the network within a region into patches of connected tiles.
+ * @param index The region to analyse.
+ */
+void PathRegionMap::Update(uint index)
+{
+	Region &r = this->regions[index];
+	memset(r.labels, 0, sizeof(r.labels));
+	r.num_patches = 0;
+	r.jumps.Clear();
+	r.valid = true;
+
+	uint x0 = (index % this->size_x) << PATH_REGION_BITS;
+	uint y0 = (index / this->size_x) << PATH_REGION_BITS;
+	SmallVector<TileIndex, 64> stack;
+	for (uint i = 0; i < lengthof(r.labels); i++) {
+		if (r.labels[i] != 0) continue;
+		TileIndex start = TileXY(x0 + i % PATH_REGION_SIZE, y0 + i / PATH_REGION_SIZE);
+		if (this->get_sides(start, this->param) == 0) continue;
+
+		/* Patches beyond the maximum are merged; that only makes the graph less precise. */
+		if (r.num_patches < UINT8_MAX) r.num_patches++;
+		r.labels[i] = r.num_patches;
+		*stack.Append() = start;
+
+		while (stack.Length() > 0) {
+			TileIndex tile = stack[stack.Length() - 1];
+			stack.Resize(stack.Length() - 1);
+
+			uint sides = this->get_sides(tile, this->param);
+			for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+				if (!HasBit(sides, dir)) continue;
+
+				TileIndex next = this->GetNeighbour(tile, dir);
+				if (next == INVALID_TILE || !HasBit(this->get_sides(next, this->param), ReverseDiagDir(dir))) continue;
+
+				if (this->GetRegionIndex(next) != index) {
+					/* Plain neighbours are found by scanning the edges; the ones far away have to be remembered. */
+					if (DistanceManhattan(tile, next) > 1) r.jumps.Include(tile);
+					continue;
+				}
+
+				uint local = GetLocalIndex(next);
+				if (r.labels[local] != 0) continue;
+				r.labels[local] = r.num_patches;
+				*stack.Append() = next;
+			}
+		}
+	}
+}
+
+/**
+ * Get the patch of a tile, analysing its region when needed.
+ * The regions have to be allocated already.
+ * @param tile The tile.
+ * @param[out] patch The patch of the tile.
+ * @return False when the tile is not part of the network.
+ */
+bool PathRegionMap::GetPatchOfTile(TileIndex tile, PathRegionPatch *patch)
+{
+	uint index = this->GetRegionIndex(tile);
+	if (!this->regions[index].valid) this->Update(index);
+
+	byte label = this->regions[index].labels[GetLocalIndex(tile)];
+	if (label == 0) return false;
+
+	patch->region = index;
+	patch->patch = label;
+	return true;
+}
+
+/**
+ * Get the patch of a tile.
+ * @param tile The tile.
+ * @param[out] patch The patch of the tile.
+ * @return False when the tile is not part of the network.
+ */
+bool PathRegionMap::GetPatch(TileIndex tile, PathRegionPatch *patch)
+{
+	this->Allocate();
+	return this->GetPatchOfTile(tile, patch);
+}
+
+/**
+ * Check whether a tile belongs to a patch.
+ * @param tile The tile.
+ * @param patch The patch.
+ * @return True when the tile is part of the network and of \a patch.
+ */
+bool PathRegionMap::IsInPatch(TileIndex tile, const PathRegionPatch &patch)
+{
+	PathRegionPatch p;
+	return this->GetPatch(tile, &p) && p == patch;
+}
+
+/**
+ * Get the tiles covered by a region.
+ * @param region The region.
+ * @return The area of the region.
+ */
+TileArea PathRegionMap::GetRegionArea(uint region) const
+{
+	return TileArea(TileXY((region % this->size_x) << PATH_REGION_BITS, (region / this->size_x) << PATH_REGION_BITS), PATH_REGION_SIZE, PATH_REGION_SIZE);
+}
+
+/**
+ * Find the patches a route passes through.
+ * @param start The patch to start at.
+ * @param goals The patches to go to.
+ * @param num_goals Number of goals.
+ * @param[out] path The patches of the route, starting with \a start and ending with the reached goal.
+ * @param max_nodes Maximum number of patches to look at.
+ * @return False when no goal can be reached, or not within \a max_nodes.
+ */
+bool PathRegionMap::FindPath(const PathRegionPatch &start, const PathRegionPatch *goals, uint num_goals, PathRegionPath *path, uint max_nodes)
+{
+	typedef std::pair<uint, uint32> OpenItem;
+	std::priority_queue<OpenItem, std::vector<OpenItem>, std::greater<OpenItem> > open;
+	std::map<uint32, PathRegionNode> nodes;
+	SmallVector<PathRegionPatch, 16> neighbours;
+
+	this->Allocate();
+	path->Clear();
+	if (num_goals == 0) return false;
+
+	uint32 start_key = GetPatchKey(start);
+	PathRegionNode &start_node = nodes[start_key];
+	start_node.cost = 0;
+	start_node.parent = start_key;
+	start_node.closed = false;
+	open.push(OpenItem(0, start_key));
+
+	while (!open.empty()) {
+		uint32 key = open.top().second;
+		open.pop();
+
+		PathRegionNode &node = nodes[key];
+		if (node.closed) continue;
+		node.closed = true;
+
+		PathRegionPatch cur = GetKeyPatch(key);
+		for (uint i = 0; i < num_goals; i++) {
+			if (goals[i] != cur) continue;
+
+			for (;;) {
+				*path->Append() = GetKeyPatch(key);
+				if (key == start_key) break;
+				key = nodes[key].parent;
+			}
+			for (uint a = 0, b = path->Length() - 1; a < b; a++, b--) Swap((*path)[a], (*path)[b]);
+			return true;
+		}
+		if (nodes.size() > max_nodes) break;
+
+		/* The region is analysed already, as one of its patches was reached. */
+		const Region &r = this->regions[cur.region];
+		uint x0 = (cur.region % this->size_x) << PATH_REGION_BITS;
+		uint y0 = (cur.region / this->size_x) << PATH_REGION_BITS;
+
+		neighbours.Clear();
+		for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+			TileIndexDiffC offset = TileIndexDiffCByDiagDir(dir);
+			for (uint i = 0; i < PATH_REGION_SIZE; i++) {
+				/* Walk along the edge of the region on side dir. */
+				uint x = offset.x == 0 ? i : (offset.x < 0 ? 0 : PATH_REGION_SIZE - 1);
+				uint y = offset.y == 0 ? i : (offset.y < 0 ? 0 : PATH_REGION_SIZE - 1);
+				if (r.labels[y * PATH_REGION_SIZE + x] != cur.patch) continue;
+
+				TileIndex tile = TileXY(x0 + x, y0 + y);
+				if (!HasBit(this->get_sides(tile, this->param), dir)) continue;
+
+				TileIndex next = this->GetNeighbour(tile, dir);
+				if (next == INVALID_TILE || !HasBit(this->get_sides(next, this->param), ReverseDiagDir(dir))) continue;
+
+				PathRegionPatch patch;
+				if (this->GetPatchOfTile(next, &patch) && patch.region != cur.region) neighbours.Include(patch);
+			}
+		}
+		for (const TileIndex *jump = r.jumps.Begin(); jump != r.jumps.End(); jump++) {
+			if (r.labels[GetLocalIndex(*jump)] != cur.patch) continue;
+
+			PathRegionPatch patch;
+			if (this->GetPatchOfTile(GetOtherTunnelBridgeEnd(*jump), &patch)) neighbours.Include(patch);
+		}
+
+		for (const PathRegionPatch *next = neighbours.Begin(); next != neighbours.End(); next++) {
+			uint cost = node.cost + this->GetRegionDistance(cur.region, next->region);
+			uint32 next_key = GetPatchKey(*next);
+
+			std::map<uint32, PathRegionNode>::iterator it = nodes.find(next_key);
+			if (it != nodes.end() && (it->second.closed || it->second.cost <= cost)) continue;
+
+			PathRegionNode &next_node = nodes[next_key];
+			next_node.cost = cost;
+			next_node.parent = key;
+			next_node.closed = false;
+
+			uint estimate = UINT_MAX;
+			for (uint i = 0; i < num_goals; i++) estimate = min(estimate, this->GetRegionDistance(next->region, goals[i].region));
+			open.push(OpenItem(cost + estimate, next_key));
+		}
+	}
+
+	path->Clear();
+	return false;
+}
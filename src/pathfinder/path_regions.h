@@ -0,0 +1,127 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file path_regions.h Coarse connectivity of a transport network, for guiding pathfinders over long distances. */
+
+#ifndef PATH_REGIONS_H
+#define PATH_REGIONS_H
+
+#include "../map_func.h"
+#include "../tilearea_type.h"
+#include "../core/smallvec_type.hpp"
+
+static const uint PATH_REGION_BITS = 4;                     ///< Log2 of the side length of a region.
+static const uint PATH_REGION_SIZE = 1 << PATH_REGION_BITS; ///< Side length of a region in tiles.
+
+/** A set of tiles of a region that are connected to each other within the region. */
+struct PathRegionPatch {
+	uint region; ///< Index of the region.
+	byte patch;  ///< Number of the patch within the region, starting at 1.
+
+	inline bool operator ==(const PathRegionPatch &other) const
+	{
+		return this->region == other.region && this->patch == other.patch;
+	}
+
+	inline bool operator !=(const PathRegionPatch &other) const
+	{
+		return !(*this == other);
+	}
+};
+
+/** A path through patches, from the start to the goal. */
+typedef SmallVector<PathRegionPatch, 32> PathRegionPath;
+
+/**
+ * Get the sides of a tile over which the network continues.
+ * For the ends of tunnels and bridges the side towards the wormhole has to be included.
+ * @param tile The tile to check.
+ * @param param The parameter given to the PathRegionMap.
+ * @return Bit mask of DiagDirection the network leaves the tile through.
+ */
+typedef uint PathRegionSidesProc(TileIndex tile, uint param);
+
+/**
+ * The map divided into square regions, with for each region the parts of
+ * the network within it that are connected to each other. The patches of
+ * all regions form a small graph that is searched to find which regions a
+ * route passes through, before a detailed pathfinder searches the route
+ * itself over a short distance.
+ *
+ * Regions are analysed lazily; the owner has to call Invalidate() for every
+ * tile where the network changes. Patches that are connected via tiles
+ * outside of their region end up as separate patches, so the graph may
+ * consider two tiles connected when they are not, but never the other way
+ * around.
+ */
+class PathRegionMap {
+	/** Analysis of a single region. */
+	struct Region {
+		bool valid;                       ///< Whether the labels are up to date.
+		byte num_patches;                 ///< Number of patches in the region.
+		byte labels[PATH_REGION_SIZE * PATH_REGION_SIZE]; ///< Patch of each tile of the region, 0 when the tile is not part of the network.
+		SmallVector<TileIndex, 2> jumps;  ///< Tunnel and bridge heads leading out of the region.
+	};
+
+	PathRegionSidesProc *get_sides; ///< Function to get the connected sides of a tile.
+	uint param;                     ///< Parameter for #get_sides.
+	Region *regions;                ///< The regions, or NULL when not allocated yet.
+	uint size_x;                    ///< Number of regions along the X axis.
+	uint size_y;                    ///< Number of regions along the Y axis.
+
+	void Allocate();
+	void Update(uint index);
+	TileIndex GetNeighbour(TileIndex tile, DiagDirection dir) const;
+	bool GetPatchOfTile(TileIndex tile, PathRegionPatch *patch);
+
+	/**
+	 * Get the region of a tile.
+	 * @param tile The tile.
+	 * @return Index of the region.
+	 */
+	inline uint GetRegionIndex(TileIndex tile) const
+	{
+		return (TileY(tile) >> PATH_REGION_BITS) * this->size_x + (TileX(tile) >> PATH_REGION_BITS);
+	}
+
+	/**
+	 * Get the position of a tile within its region.
+	 * @param tile The tile.
+	 * @return Index in Region::labels.
+	 */
+	static inline uint GetLocalIndex(TileIndex tile)
+	{
+		return (TileY(tile) & (PATH_REGION_SIZE - 1)) * PATH_REGION_SIZE + (TileX(tile) & (PATH_REGION_SIZE - 1));
+	}
+
+	/**
+	 * Get the distance between two regions counted in regions.
+	 * @param a The first region.
+	 * @param b The second region.
+	 * @return Manhattan distance between the regions.
+	 */
+	inline uint GetRegionDistance(uint a, uint b) const
+	{
+		return Delta(a % this->size_x, b % this->size_x) + Delta(a / this->size_x, b / this->size_x);
+	}
+
+public:
+	PathRegionMap(PathRegionSidesProc *get_sides, uint param);
+	~PathRegionMap();
+
+	void Invalidate(TileIndex tile);
+	void InvalidateAll();
+
+	bool GetPatch(TileIndex tile, PathRegionPatch *patch);
+	bool IsInPatch(TileIndex tile, const PathRegionPatch &patch);
+	TileArea GetRegionArea(uint region) const;
+	bool FindPath(const PathRegionPatch &start, const PathRegionPatch *goals, uint num_goals, PathRegionPath *path, uint max_nodes);
+};
+
+#endif /* PATH_REGIONS_H */
@@ -13,7 +13,9 @@
 #define PF_PERFORMANCE_TIMER_HPP
 
 #include "../debug.h"
+#include "../tick_profiler.h"
 
+/** Accumulating timer for measuring the CPU time of parts of the pathfinders. */
 struct CPerformanceTimer
 {
 	int64    m_start;
@@ -38,12 +40,13 @@ struct CPerformanceTimer
 
 	inline int64 QueryTime()
 	{
-		return ottd_rdtsc();
+		return GetProfilerTime();
 	}
 
 	inline int64 QueryFrequency()
 	{
-		return ((int64)2200 * 1000000);
+		/* GetProfilerTime() counts microseconds. */
+		return 1000000;
 	}
 };
 
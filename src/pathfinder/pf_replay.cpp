@@ -0,0 +1,339 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file pf_replay.cpp Recording of pathfinder queries and replaying them for benchmarking.
+ *
+ * A capture saves the game and then writes every pathfinder invocation to
+ * a query file next to the savegame, one query per line. The replay runs
+ * the recorded queries against the loaded savegame with every pathfinder
+ * that can handle them. Before each query the vehicle is put back in the
+ * position and with the order it had when the query was recorded, so the
+ * pathfinders get the same input regardless of how far the game has run.
+ * Only the lead vehicle is moved and reservations are not replayed, so the
+ * replayed result can differ from the recorded one; those differences are
+ * reported as mismatches.
+ */
+
+#include "../stdafx.h"
+#include "../train.h"
+#include "../roadveh.h"
+#include "../ship.h"
+#include "../fileio_func.h"
+#include "../string_func.h"
+#include "../console_func.h"
+#include "../date_func.h"
+#include "../saveload/saveload.h"
+#include "../core/random_func.hpp"
+#include "../tick_profiler.h"
+#include "npf/npf_func.h"
+#include "opf/opf_ship.h"
+#include "yapf/yapf.h"
+#include "pf_replay.h"
+
+#include "../safeguards.h"
+
+/** Version of the query file format. */
+static const uint PF_QUERY_FILE_VERSION = 1;
+
+uint _pf_nodes_expanded = 0;    ///< Number of nodes expanded by all pathfinders so far.
+bool _pf_capture_active = false; ///< Whether pathfinder queries are being recorded.
+static FILE *_pf_capture_file = NULL; ///< File the queries are recorded to.
+
+/** A single recorded pathfinder invocation. */
+struct PathfinderQuery {
+	PathfinderQueryType type; ///< Kind of vehicle searching.
+	VehicleID vehicle;        ///< The vehicle searching.
+	uint pathfinder;          ///< The pathfinder that was used, see #VehiclePathFinders.
+	TileIndex veh_tile;       ///< Tile of the vehicle.
+	uint direction;           ///< Direction of the vehicle.
+	uint state;               ///< Track of a train, state of a road vehicle or ship.
+	TileIndex tile;           ///< Tile the vehicle is about to enter.
+	uint enterdir;            ///< Direction the tile is entered from.
+	uint choices;             ///< Tracks or trackdirs to choose from.
+	TileIndex dest_tile;      ///< Destination tile of the vehicle.
+	uint32 order;             ///< Packed current order of the vehicle.
+	uint reserve;             ///< Whether the train reserved its path.
+	uint result;              ///< The chosen track or trackdir.
+	uint path_found;          ///< Whether a path to the destination was found.
+};
+
+/** Measurements of one pathfinder over a replay. */
+struct PathfinderReplayStats {
+	uint queries;    ///< Number of queries run.
+	uint mismatches; ///< Number of queries with a result other than recorded.
+	uint64 nodes;    ///< Number of nodes expanded.
+	uint64 time;     ///< Time spent searching, in microseconds.
+	uint32 hash;     ///< Hash over all results.
+};
+
+/** Names of the query types, for the query file and the report. */
+static const char * const _pf_query_type_names[] = { "train", "roadveh", "ship" };
+assert_compile(lengthof(_pf_query_type_names) == PFQ_END);
+
+/** Names of the pathfinders, indexed by #VehiclePathFinders. */
+static const char * const _pf_names[] = { "OPF", "NPF", "YAPF" };
+
+/**
+ * Get the vehicle state the pathfinders look at besides the tile and direction.
+ * @param type Kind of vehicle.
+ * @param v The vehicle.
+ * @return The track or state of the vehicle.
+ */
+static uint GetQueryVehicleState(PathfinderQueryType type, const Vehicle *v)
+{
+	switch (type) {
+		case PFQ_TRAIN:   return Train::From(v)->track;
+		case PFQ_ROADVEH: return RoadVehicle::From(v)->state;
+		case PFQ_SHIP:    return Ship::From(v)->state;
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Set the vehicle state the pathfinders look at besides the tile and direction.
+ * @param type Kind of vehicle.
+ * @param v The vehicle.
+ * @param state The track or state of the vehicle.
+ */
+static void SetQueryVehicleState(PathfinderQueryType type, Vehicle *v, uint state)
+{
+	switch (type) {
+		case PFQ_TRAIN:   Train::From(v)->track = (TrackBits)state; break;
+		case PFQ_ROADVEH: RoadVehicle::From(v)->state = state; break;
+		case PFQ_SHIP:    Ship::From(v)->state = (TrackBits)state; break;
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Save the game and start recording pathfinder queries.
+ * @param name Name of the recording; the game is saved as \a name.sav and the queries go to \a name.pfq.
+ * @return False when the game could not be saved or the query file could not be created.
+ */
+bool PathfinderCaptureStart(const char *name)
+{
+	PathfinderCaptureStop();
+
+	char filename[MAX_PATH];
+	seprintf(filename, lastof(filename), "%s.sav", name);
+	if (SaveOrLoad(filename, SL_SAVE, SAVE_DIR) != SL_OK) return false;
+
+	seprintf(filename, lastof(filename), "%s.pfq", name);
+	_pf_capture_file = FioFOpenFile(filename, "w", SAVE_DIR);
+	if (_pf_capture_file == NULL) return false;
+
+	fprintf(_pf_capture_file, "pfq %u %u %u %d %u\n", PF_QUERY_FILE_VERSION, MapSizeX(), MapSizeY(), _date, _date_fract);
+	_pf_capture_active = true;
+	return true;
+}
+
+/** Stop recording pathfinder queries, if a recording is running. */
+void PathfinderCaptureStop()
+{
+	if (_pf_capture_file != NULL) FioFCloseFile(_pf_capture_file);
+	_pf_capture_file = NULL;
+	_pf_capture_active = false;
+}
+
+/**
+ * Record a pathfinder query.
+ * @param type Kind of vehicle searching.
+ * @param v The vehicle searching.
+ * @param tile The tile the vehicle is about to enter.
+ * @param enterdir The direction the tile is entered from.
+ * @param choices The tracks or trackdirs the pathfinder had to choose from.
+ * @param reserve Whether the train reserved its path.
+ * @param result The chosen track or trackdir.
+ * @param path_found Whether a path to the destination was found.
+ */
+void PathfinderCaptureQuery(PathfinderQueryType type, const Vehicle *v, TileIndex tile, DiagDirection enterdir, uint choices, bool reserve, uint result, bool path_found)
+{
+	uint pathfinder;
+	switch (type) {
+		case PFQ_TRAIN:   pathfinder = _settings_game.pf.pathfinder_for_trains; break;
+		case PFQ_ROADVEH: pathfinder = _settings_game.pf.pathfinder_for_roadvehs; break;
+		case PFQ_SHIP:    pathfinder = _settings_game.pf.pathfinder_for_ships; break;
+		default: NOT_REACHED();
+	}
+
+	fprintf(_pf_capture_file, "%s %u %u %u %u %u %u %u %u %u %u %u %u %u\n", _pf_query_type_names[type], v->index, pathfinder,
+			v->tile, (uint)v->direction, GetQueryVehicleState(type, v), tile, enterdir, choices, v->dest_tile, v->current_order.Pack(),
+			reserve ? 1 : 0, result, path_found ? 1 : 0);
+}
+
+/**
+ * Read the next query from a query file.
+ * @param f The query file.
+ * @param[out] q The query.
+ * @return False at the end of the file or when the query could not be parsed.
+ */
+static bool ReadPathfinderQuery(FILE *f, PathfinderQuery *q)
+{
+	char type[16];
+	if (fscanf(f, "%15s %u %u %u %u %u %u %u %u %u %u %u %u %u", type, &q->vehicle, &q->pathfinder, &q->veh_tile, &q->direction, &q->state,
+			&q->tile, &q->enterdir, &q->choices, &q->dest_tile, &q->order, &q->reserve, &q->result, &q->path_found) != 14) {
+		return false;
+	}
+
+	for (uint i = 0; i < PFQ_END; i++) {
+		if (strcmp(type, _pf_query_type_names[i]) != 0) continue;
+		q->type = (PathfinderQueryType)i;
+		return q->pathfinder < lengthof(_pf_names) && IsValidTile(q->veh_tile) && IsValidTile(q->tile) && q->enterdir < DIAGDIR_END;
+	}
+	return false;
+}
+
+/**
+ * Run a query with a pathfinder.
+ * @param q The query.
+ * @param v The vehicle of the query, already in the recorded state.
+ * @param pathfinder The pathfinder to use.
+ * @param[out] path_found Whether a path to the destination was found.
+ * @return The chosen track or trackdir.
+ */
+static uint RunPathfinderQuery(const PathfinderQuery &q, const Vehicle *v, uint pathfinder, bool &path_found)
+{
+	DiagDirection enterdir = (DiagDirection)q.enterdir;
+	switch (q.type) {
+		case PFQ_TRAIN:
+			if (pathfinder == VPF_NPF) return NPFTrainChooseTrack(Train::From(v), q.tile, enterdir, (TrackBits)q.choices, path_found, false, NULL);
+			return YapfTrainChooseTrack(Train::From(v), q.tile, enterdir, (TrackBits)q.choices, path_found, false, NULL);
+
+		case PFQ_ROADVEH:
+			if (pathfinder == VPF_NPF) return NPFRoadVehicleChooseTrack(RoadVehicle::From(v), q.tile, enterdir, (TrackdirBits)q.choices, path_found);
+			return YapfRoadVehicleChooseTrack(RoadVehicle::From(v), q.tile, enterdir, (TrackdirBits)q.choices, path_found);
+
+		case PFQ_SHIP:
+			if (pathfinder == VPF_OPF) return OPFShipChooseTrack(Ship::From(v), q.tile, enterdir, (TrackBits)q.choices, path_found);
+			if (pathfinder == VPF_NPF) return NPFShipChooseTrack(Ship::From(v), q.tile, enterdir, (TrackBits)q.choices, path_found);
+			return YapfShipChooseTrack(Ship::From(v), q.tile, enterdir, (TrackBits)q.choices, path_found);
+
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Add a value to a FNV-1a hash.
+ * @param hash The hash so far.
+ * @param value The value to add.
+ * @return The new hash.
+ */
+static inline uint32 AddToHash(uint32 hash, uint32 value)
+{
+	for (uint i = 0; i < 4; i++) {
+		hash ^= GB(value, i * 8, 8);
+		hash *= 16777619;
+	}
+	return hash;
+}
+
+/**
+ * Replay recorded pathfinder queries against the current game and print how the pathfinders performed.
+ * The game should be the savegame of the recording; the vehicles are left as they were.
+ * @param name Name of the recording, as given to PathfinderCaptureStart().
+ * @return False when the query file could not be read.
+ */
+bool PathfinderReplay(const char *name)
+{
+	char filename[MAX_PATH];
+	seprintf(filename, lastof(filename), "%s.pfq", name);
+	FILE *f = FioFOpenFile(filename, "r", SAVE_DIR);
+	if (f == NULL) return false;
+
+	uint version, size_x, size_y, date_fract;
+	int date;
+	if (fscanf(f, "pfq %u %u %u %d %u", &version, &size_x, &size_y, &date, &date_fract) != 5 || version != PF_QUERY_FILE_VERSION) {
+		FioFCloseFile(f);
+		return false;
+	}
+	if (size_x != MapSizeX() || size_y != MapSizeY()) {
+		IConsolePrintF(CC_ERROR, "The queries were recorded on a map of %ux%u tiles.", size_x, size_y);
+		FioFCloseFile(f);
+		return true;
+	}
+	if (date != _date || date_fract != _date_fract) {
+		IConsolePrint(CC_WARNING, "The game is not at the date the queries were recorded at; results will differ.");
+	}
+
+	PathfinderReplayStats stats[PFQ_END][lengthof(_pf_names)];
+	for (uint i = 0; i < PFQ_END; i++) {
+		for (uint j = 0; j < lengthof(_pf_names); j++) {
+			stats[i][j].queries = 0;
+			stats[i][j].mismatches = 0;
+			stats[i][j].nodes = 0;
+			stats[i][j].time = 0;
+			stats[i][j].hash = 2166136261U;
+		}
+	}
+
+	/* Pathfinders may draw random numbers; keep the game's random state as it is. */
+	SavedRandomSeeds saved_seeds;
+	SaveRandomSeeds(&saved_seeds);
+
+	uint skipped = 0;
+	PathfinderQuery q;
+	while (ReadPathfinderQuery(f, &q)) {
+		Vehicle *v = Vehicle::GetIfValid(q.vehicle);
+		if (v == NULL || !v->IsPrimaryVehicle() || v->type != (q.type == PFQ_TRAIN ? VEH_TRAIN : q.type == PFQ_ROADVEH ? VEH_ROAD : VEH_SHIP)) {
+			skipped++;
+			continue;
+		}
+
+		/* Put the vehicle where it was when the query was recorded. */
+		TileIndex tile = v->tile;
+		Direction direction = v->direction;
+		uint state = GetQueryVehicleState(q.type, v);
+		TileIndex dest_tile = v->dest_tile;
+		Order order = v->current_order;
+
+		v->tile = q.veh_tile;
+		v->direction = (Direction)q.direction;
+		SetQueryVehicleState(q.type, v, q.state);
+		v->dest_tile = q.dest_tile;
+		v->current_order.AssignOrder(Order(q.order));
+
+		for (uint pathfinder = (q.type == PFQ_SHIP ? VPF_OPF : VPF_NPF); pathfinder < lengthof(_pf_names); pathfinder++) {
+			PathfinderReplayStats &s = stats[q.type][pathfinder];
+			RestoreRandomSeeds(saved_seeds);
+
+			bool path_found = true;
+			uint nodes = _pf_nodes_expanded;
+			uint64 start = GetProfilerTime();
+			uint result = RunPathfinderQuery(q, v, pathfinder, path_found);
+			s.time += GetProfilerTime() - start;
+			s.nodes += _pf_nodes_expanded - nodes;
+			s.queries++;
+			s.hash = AddToHash(AddToHash(s.hash, result), path_found ? 1 : 0);
+
+			/* Reserving searches were replayed without reserving, so they cannot be compared. */
+			if (pathfinder == q.pathfinder && q.reserve == 0 && (result != q.result || path_found != (q.path_found != 0))) s.mismatches++;
+		}
+
+		v->tile = tile;
+		v->direction = direction;
+		SetQueryVehicleState(q.type, v, state);
+		v->dest_tile = dest_tile;
+		v->current_order = order;
+	}
+	FioFCloseFile(f);
+
+	RestoreRandomSeeds(saved_seeds);
+
+	if (skipped != 0) IConsolePrintF(CC_WARNING, "Skipped %u queries of vehicles that do not exist.", skipped);
+	for (uint i = 0; i < PFQ_END; i++) {
+		for (uint j = 0; j < lengthof(_pf_names); j++) {
+			const PathfinderReplayStats &s = stats[i][j];
+			if (s.queries == 0) continue;
+			IConsolePrintF(CC_DEFAULT, "  %-8s %-5s queries: %6u  nodes: " OTTD_PRINTF64 "  time: %9.3f ms  hash: %08x  mismatches: %u",
+					_pf_query_type_names[i], _pf_names[j], s.queries, s.nodes, s.time / 1000.0, s.hash, s.mismatches);
+		}
+	}
+	return true;
+}
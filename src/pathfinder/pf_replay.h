@@ -0,0 +1,35 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file pf_replay.h Recording of pathfinder queries and replaying them for benchmarking. */
+
+#ifndef PF_REPLAY_H
+#define PF_REPLAY_H
+
+#include "../vehicle_type.h"
+#include "../tile_type.h"
+#include "../direction_type.h"
+
+/** Kinds of recorded pathfinder queries. */
+enum PathfinderQueryType {
+	PFQ_TRAIN,   ///< A train choosing a track.
+	PFQ_ROADVEH, ///< A road vehicle choosing a trackdir.
+	PFQ_SHIP,    ///< A ship choosing a track.
+	PFQ_END,     ///< End marker.
+};
+
+extern uint _pf_nodes_expanded;
+extern bool _pf_capture_active;
+
+bool PathfinderCaptureStart(const char *name);
+void PathfinderCaptureStop();
+void PathfinderCaptureQuery(PathfinderQueryType type, const Vehicle *v, TileIndex tile, DiagDirection enterdir, uint choices, bool reserve, uint result, bool path_found);
+bool PathfinderReplay(const char *name);
+
+#endif /* PF_REPLAY_H */
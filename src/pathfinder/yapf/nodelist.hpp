@@ -14,7 +14,7 @@
 
 #include "../../misc/array.hpp"
 #include "../../misc/hashtable.hpp"
-#include "../../misc/binaryheap.hpp"
+#include "../../misc/dary_heap.hpp"
 
 /**
  * Hash table based node list multi-container class.
@@ -29,18 +29,37 @@ public:
 	typedef SmallArray<Titem_, 65536, 256> CItemArray;           ///< Type that we will use as item container.
 	typedef CHashTableT<Titem_, Thash_bits_open_  > COpenList;   ///< How pointers to open nodes will be stored.
 	typedef CHashTableT<Titem_, Thash_bits_closed_> CClosedList; ///< How pointers to closed nodes will be stored.
-	typedef CBinaryHeapT<Titem_> CPriorityQueue;                 ///< How the priority queue will be managed.
+	typedef CDaryHeapT<Titem_> CPriorityQueue;                   ///< How the priority queue will be managed.
+
+	/** The memory of a node list, which is handed on to the next node list when a search is done. */
+	struct Storage {
+		CItemArray     arr;   ///< The item data.
+		CPriorityQueue queue; ///< The priority queue.
+
+		Storage() : queue(2048) {}
+	};
 
 protected:
-	CItemArray      m_arr;        ///< Here we store full item data (Titem_).
+	Storage        *m_storage;    ///< Memory of m_arr and m_open_queue.
+	CItemArray     &m_arr;        ///< Here we store full item data (Titem_).
 	COpenList       m_open;       ///< Hash table of pointers to open item data.
 	CClosedList     m_closed;     ///< Hash table of pointers to closed item data.
-	CPriorityQueue  m_open_queue; ///< Priority queue of pointers to open item data.
+	CPriorityQueue &m_open_queue; ///< Priority queue of pointers to open item data, keyed by their cost estimate.
 	Titem          *m_new_node;   ///< New open node under construction.
 
+	static Storage *s_spare;      ///< Memory of the last finished search, so the next search does not need to allocate it again.
+
+	/** Take the spare memory, or allocate new memory when another search is using it. */
+	static Storage *AcquireStorage()
+	{
+		Storage *storage = s_spare;
+		s_spare = NULL;
+		return storage != NULL ? storage : new Storage();
+	}
+
 public:
 	/** default constructor */
-	CNodeList_HashTableT() : m_open_queue(2048)
+	CNodeList_HashTableT() : m_storage(AcquireStorage()), m_arr(m_storage->arr), m_open_queue(m_storage->queue)
 	{
 		m_new_node = NULL;
 	}
@@ -48,6 +67,13 @@ public:
 	/** destructor */
 	~CNodeList_HashTableT()
 	{
+		m_arr.Reset();
+		m_open_queue.Clear();
+		if (s_spare == NULL) {
+			s_spare = m_storage;
+		} else {
+			delete m_storage;
+		}
 	}
 
 	/** return number of open nodes */
@@ -84,7 +110,7 @@ public:
 	{
 		assert(m_closed.Find(item.GetKey()) == NULL);
 		m_open.Push(item);
-		m_open_queue.Include(&item);
+		m_open_queue.Include(&item, item.GetCostEstimate());
 		if (&item == m_new_node) {
 			m_new_node = NULL;
 		}
@@ -159,4 +185,7 @@ public:
 	}
 };
 
+template <class Titem_, int Thash_bits_open_, int Thash_bits_closed_>
+typename CNodeList_HashTableT<Titem_, Thash_bits_open_, Thash_bits_closed_>::Storage *CNodeList_HashTableT<Titem_, Thash_bits_open_, Thash_bits_closed_>::s_spare = NULL;
+
 #endif /* NODELIST_HPP */
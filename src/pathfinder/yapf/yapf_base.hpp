@@ -136,6 +136,7 @@ public:
 			if (n == NULL) {
 				break;
 			}
+			_pf_nodes_expanded++;
 
 			/* if the best open node was worse than the best path found, we can finish */
 			if (m_pBestDestNode != NULL && m_pBestDestNode->GetCost() < n->GetCostEstimate()) {
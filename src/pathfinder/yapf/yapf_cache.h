@@ -21,4 +21,16 @@
  */
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track);
 
+/**
+ * Use this function to notify YAPF that the road layout has changed.
+ * @param tile the tile that is changed, or INVALID_TILE when any tile might have changed
+ */
+void YapfNotifyRoadLayoutChange(TileIndex tile);
+
+/**
+ * Use this function to notify YAPF that the water layout has changed.
+ * @param tile the tile that is changed, or INVALID_TILE when any tile might have changed
+ */
+void YapfNotifyWaterLayoutChange(TileIndex tile);
+
 #endif /* YAPF_CACHE_H */
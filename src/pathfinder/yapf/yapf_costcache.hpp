@@ -92,19 +92,117 @@ public:
 };
 
 
+/**
+ * Rectangle of tiles a cached segment depends on. It contains all tiles
+ *  of the segment, so a change of the track layout only needs to evict
+ *  the segments whose area contains the changed tile or one of its
+ *  neighbours.
+ */
+struct CSegmentCostCacheArea
+{
+	uint16 m_min_x; ///< smallest x coordinate of the area
+	uint16 m_min_y; ///< smallest y coordinate of the area
+	uint16 m_max_x; ///< largest x coordinate of the area
+	uint16 m_max_y; ///< largest y coordinate of the area
+
+	/** make the area empty */
+	inline void Clear()
+	{
+		m_min_x = m_min_y = UINT16_MAX;
+		m_max_x = m_max_y = 0;
+	}
+
+	/** return true if the area contains no tiles */
+	inline bool IsEmpty() const
+	{
+		return m_min_x > m_max_x;
+	}
+
+	/** make the area contain only the given tile */
+	inline void Set(TileIndex tile)
+	{
+		m_min_x = m_max_x = TileX(tile);
+		m_min_y = m_max_y = TileY(tile);
+	}
+
+	/** grow the area so it contains the given tile */
+	inline void Add(TileIndex tile)
+	{
+		uint x = TileX(tile);
+		uint y = TileY(tile);
+		if (x < m_min_x) m_min_x = x;
+		if (x > m_max_x) m_max_x = x;
+		if (y < m_min_y) m_min_y = y;
+		if (y > m_max_y) m_max_y = y;
+	}
+
+	/** grow the area so it contains the other area */
+	inline void Add(const CSegmentCostCacheArea &other)
+	{
+		m_min_x = min(m_min_x, other.m_min_x);
+		m_max_x = max(m_max_x, other.m_max_x);
+		m_min_y = min(m_min_y, other.m_min_y);
+		m_max_y = max(m_max_y, other.m_max_y);
+	}
+
+	/** grow a non-empty area by one tile in each direction */
+	inline void Expand()
+	{
+		if (m_min_x > 0) m_min_x--;
+		if (m_min_y > 0) m_min_y--;
+		if (m_max_x < UINT16_MAX) m_max_x++;
+		if (m_max_y < UINT16_MAX) m_max_y++;
+	}
+
+	/** return true if both areas have at least one tile in common */
+	inline bool Intersects(const CSegmentCostCacheArea &other) const
+	{
+		return m_min_x <= other.m_max_x && other.m_min_x <= m_max_x &&
+				m_min_y <= other.m_max_y && other.m_min_y <= m_max_y;
+	}
+};
+
 /**
  * Base class for segment cost cache providers. Contains global counter
  *  of track layout changes and static notification function called whenever
  *  the track layout changes. It is implemented as base class because it needs
  *  to be shared between all rail YAPF types (one shared counter, one notification
  *  function.
+ *  The areas of the last changes are remembered, so each cache can evict only
+ *  the segments near the changed tiles instead of being flushed completely.
  */
 struct CSegmentCostCacheBase
 {
+	static const uint C_CHANGE_LOG_SIZE = 256; ///< number of track layout changes remembered for the caches
+
 	static int   s_rail_change_counter;
+	static int   s_rail_flush_counter; ///< value of s_rail_change_counter after the last change that invalidated everything
+	static CSegmentCostCacheArea s_changed_areas[C_CHANGE_LOG_SIZE]; ///< areas of the last changes, indexed by change counter
+
+	static uint  s_hits;    ///< number of segments found in a cache
+	static uint  s_misses;  ///< number of segments that had to be calculated
+	static uint  s_evicted; ///< number of segments evicted because of track layout changes
+	static uint  s_flushes; ///< number of times a cache was flushed completely
 
 	static void NotifyTrackLayoutChange(TileIndex tile, Track track)
 	{
+		if (tile == INVALID_TILE) {
+			s_rail_change_counter++;
+			s_rail_flush_counter = s_rail_change_counter;
+			return;
+		}
+
+		/* The neighbours might end their segments at this tile. */
+		CSegmentCostCacheArea area;
+		area.Set(tile);
+		area.Expand();
+		NotifyAreaChange(area);
+	}
+
+	/** Notify the caches that the costs of all segments intersecting the area might have changed. */
+	static void NotifyAreaChange(const CSegmentCostCacheArea &area)
+	{
+		s_changed_areas[(uint)s_rail_change_counter % C_CHANGE_LOG_SIZE] = area;
 		s_rail_change_counter++;
 	}
 };
@@ -119,10 +217,12 @@ struct CSegmentCostCacheBase
  *  of the segment (origin tile and exit-dir from this tile).
  *  Different CYapfCachedCostT types can share the same type of CSegmentCostCacheT.
  *  Look at CYapfRailSegment (yapf_node_rail.hpp) for the segment example
+ *  Evicted segments have an empty area; their storage is reused for new segments.
  */
 template <class Tsegment>
 struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 	static const int C_HASH_BITS = 14;
+	static const uint C_MAX_SEGMENTS = 1 << 19; ///< flush the cache when it grows beyond this many segments
 
 	typedef CHashTableT<Tsegment, C_HASH_BITS> HashTable;
 	typedef SmallArray<Tsegment> Heap;
@@ -130,14 +230,50 @@ struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 
 	HashTable    m_map;
 	Heap         m_heap;
+	SmallVector<Tsegment *, 16> m_free; ///< evicted segments whose storage can be reused
 
 	inline CSegmentCostCacheT() {}
 
 	/** flush (clear) the cache */
 	inline void Flush()
 	{
+		if (m_heap.Length() > 0) s_flushes++;
 		m_map.Clear();
 		m_heap.Clear();
+		m_free.Clear();
+	}
+
+	/**
+	 * Evict the segments affected by the track layout changes since the given change.
+	 *  The whole cache is flushed when the changes are not known anymore.
+	 * @param last_counter value of s_rail_change_counter the cache is up to date with
+	 */
+	inline void Invalidate(int last_counter)
+	{
+		if (s_rail_change_counter - last_counter > (int)C_CHANGE_LOG_SIZE || s_rail_flush_counter > last_counter) {
+			Flush();
+			return;
+		}
+
+		/* Quickly skip the segments that are far away from all changes. */
+		CSegmentCostCacheArea all;
+		all.Clear();
+		for (int c = last_counter; c != s_rail_change_counter; c++) all.Add(s_changed_areas[(uint)c % C_CHANGE_LOG_SIZE]);
+
+		for (uint i = 0; i < m_heap.Length(); i++) {
+			Tsegment &item = m_heap[i];
+			if (item.m_area.IsEmpty() || !item.m_area.Intersects(all)) continue;
+
+			for (int c = last_counter; c != s_rail_change_counter; c++) {
+				if (!item.m_area.Intersects(s_changed_areas[(uint)c % C_CHANGE_LOG_SIZE])) continue;
+
+				m_map.Pop(item);
+				item.m_area.Clear();
+				*m_free.Append() = &item;
+				s_evicted++;
+				break;
+			}
+		}
 	}
 
 	inline Tsegment& Get(Key &key, bool *found)
@@ -145,10 +281,17 @@ struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 		Tsegment *item = m_map.Find(key);
 		if (item == NULL) {
 			*found = false;
-			item = new (m_heap.Append()) Tsegment(key);
+			s_misses++;
+			if (m_free.Length() > 0) {
+				item = new (m_free[m_free.Length() - 1]) Tsegment(key);
+				m_free.Erase(m_free.End() - 1);
+			} else {
+				item = new (m_heap.Append()) Tsegment(key);
+			}
 			m_map.Push(*item);
 		} else {
 			*found = true;
+			s_hits++;
 		}
 		return *item;
 	}
@@ -190,15 +333,20 @@ protected:
 		/* some statistics */
 		if (last_date != _date) {
 			last_date = _date;
-			DEBUG(yapf, 2, "Pf time today: %5d ms", _total_pf_time_us / 1000);
+			DEBUG(yapf, 2, "Pf time today: %5d ms, segment cache: %u hits, %u misses, %u evicted, %u flushes",
+					_total_pf_time_us / 1000, Cache::s_hits, Cache::s_misses, Cache::s_evicted, Cache::s_flushes);
 			_total_pf_time_us = 0;
+			Cache::s_hits = Cache::s_misses = Cache::s_evicted = Cache::s_flushes = 0;
 		}
 
-		/* delete the cache sometimes... */
+		/* evict the segments touching changed tracks */
 		if (last_rail_change_counter != Cache::s_rail_change_counter) {
+			C.Invalidate(last_rail_change_counter);
 			last_rail_change_counter = Cache::s_rail_change_counter;
-			C.Flush();
 		}
+
+		/* delete the cache sometimes... */
+		if (C.m_heap.Length() >= Cache::C_MAX_SEGMENTS) C.Flush();
 		return C;
 	}
 
@@ -381,6 +381,9 @@ public:
 
 no_entry_cost: // jump here at the beginning if the node has no parent (it is the first node)
 
+			/* Remember where the segment goes, to know when its cached cost gets invalid. */
+			segment.m_area.Add(cur.tile);
+
 			/* All other tile costs will be calculated here. */
 			segment_cost += Yapf().OneTileCost(cur.tile, cur.td);
 
@@ -484,7 +487,12 @@ no_entry_cost: // jump here at the beginning if the node has no parent (it is th
 			tf = &tf_local;
 			tf_local.Init(v, Yapf().GetCompatibleRailTypes(), &Yapf().m_perf_ts_cost);
 
-			if (!tf_local.Follow(cur.tile, cur.td)) {
+			bool can_follow = tf_local.Follow(cur.tile, cur.td);
+
+			/* The segment also depends on the tile it ends in front of. */
+			if (tf_local.m_new_tile != INVALID_TILE) segment.m_area.Add(tf_local.m_new_tile);
+
+			if (!can_follow) {
 				assert(tf_local.m_err != TrackFollower::EC_NONE);
 				/* Can't move to the next tile (EOL?). */
 				if (tf_local.m_err == TrackFollower::EC_RAIL_TYPE) {
@@ -76,6 +76,7 @@ struct CYapfRailSegment
 	TileIndex              m_last_signal_tile;
 	Trackdir               m_last_signal_td;
 	EndSegmentReasonBits   m_end_segment_reason;
+	CSegmentCostCacheArea  m_area;
 	CYapfRailSegment      *m_hash_next;
 
 	inline CYapfRailSegment(const CYapfRailSegmentKey &key)
@@ -87,7 +88,9 @@ struct CYapfRailSegment
 		, m_last_signal_td(INVALID_TRACKDIR)
 		, m_end_segment_reason(ESRB_NONE)
 		, m_hash_next(NULL)
-	{}
+	{
+		m_area.Set(key.GetTile());
+	}
 
 	inline const Key& GetKey() const
 	{
@@ -19,6 +19,7 @@
 #include "../../viewport_func.h"
 #include "../../newgrf_station.h"
 #include "../../depot_base.h"
+#include "../depot_distance.hpp"
 
 #include "../../safeguards.h"
 
@@ -76,6 +77,7 @@ private:
 		TileIndex     start = tile;
 		TileIndexDiff diff = TileOffsByDiagDir(dir);
 
+		MarkReservationsChanged();
 		do {
 			if (HasStationReservation(tile)) return false;
 			SetRailStationReservation(tile, true);
@@ -115,6 +117,7 @@ private:
 		if (IsRailStationTile(tile)) {
 			TileIndex     start = tile;
 			TileIndexDiff diff = TileOffsByDiagDir(TrackdirToExitdir(ReverseTrackdir(td)));
+			MarkReservationsChanged();
 			while ((tile != m_res_fail_tile || td != m_res_fail_td) && IsCompatibleTrainStationTile(tile, start)) {
 				SetRailStationReservation(tile, false);
 				tile = TILE_ADD(tile, diff);
@@ -180,10 +183,8 @@ public:
 
 		if (target != NULL) target->okay = true;
 
-		if (Yapf().CanUseGlobalCache(*m_res_node)) {
-			YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
-		}
-
+		/* The segment cache is kept: reservations and the signal states they change
+		 * only influence costs within the signal look-ahead, which are never cached. */
 		return true;
 	}
 };
@@ -403,16 +404,16 @@ public:
 		return 't';
 	}
 
-	static Trackdir stChooseRailTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target)
+	static Trackdir stChooseRailTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target, TrainPathCache *path_cache)
 	{
 		/* create pathfinder instance */
 		Tpf pf1;
 		Trackdir result1;
 
 		if (_debug_desync_level < 2) {
-			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target);
+			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, path_cache);
 		} else {
-			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, false, NULL);
+			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, false, NULL, path_cache);
 			Tpf pf2;
 			pf2.DisableCache(true);
 			Trackdir result2 = pf2.ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target);
@@ -425,7 +426,7 @@ public:
 		return result1;
 	}
 
-	inline Trackdir ChooseRailTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target)
+	inline Trackdir ChooseRailTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target, TrainPathCache *path_cache = NULL)
 	{
 		if (target != NULL) target->tile = INVALID_TILE;
 
@@ -447,17 +448,35 @@ public:
 			/* path was found or at least suggested
 			 * walk through the path back to the origin */
 			Node *pPrev = NULL;
+			SmallVector<Node *, 16> choices;
 			while (pNode->m_parent != NULL) {
 				pPrev = pNode;
 				pNode = pNode->m_parent;
 
 				this->FindSafePositionOnNode(pPrev);
+				if (path_cache != NULL && (pNode->m_segment->m_end_segment_reason & ESRB_CHOICE_FOLLOWS) != ESRB_NONE) *choices.Append() = pPrev;
 			}
 			/* return trackdir from the best origin node (one of start nodes) */
 			Node &best_next_node = *pPrev;
 			next_trackdir = best_next_node.GetTrackdir();
 
 			if (reserve_track && path_found) this->TryReservePath(target, pNode->GetLastTile());
+
+			/* Remember the choices at the junctions following the one we are deciding on now. */
+			if (path_cache != NULL && path_found) {
+				if (choices.Length() > 0 && choices[choices.Length() - 1] == pPrev) choices.Erase(choices.End() - 1);
+				uint count = min(choices.Length(), (uint)_settings_game.pf.yapf.rail_path_cache_junctions);
+				for (uint i = 0; i < count; i++) {
+					const Node *choice = choices[choices.Length() - 1 - i];
+					path_cache->tile[i] = choice->GetTile();
+					path_cache->td[i] = choice->GetTrackdir();
+				}
+				path_cache->next = 0;
+				path_cache->count = count;
+				path_cache->order_type = v->current_order.GetType();
+				path_cache->order_dest = v->current_order.GetDestination();
+				path_cache->expire = _tick_counter + _settings_game.pf.yapf.rail_path_cache_ticks;
+			}
 		}
 
 		/* Treat the path as found if stopped on the first two way signal(s). */
@@ -648,10 +667,10 @@ struct CYapfAnySafeTileRail1 : CYapfT<CYapfRail_TypesT<CYapfAnySafeTileRail1, CF
 struct CYapfAnySafeTileRail2 : CYapfT<CYapfRail_TypesT<CYapfAnySafeTileRail2, CFollowTrackFreeRailNo90, CRailNodeListTrackDir, CYapfDestinationAnySafeTileRailT , CYapfFollowAnySafeTileRailT> > {};
 
 
-Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target)
+Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target, TrainPathCache *path_cache)
 {
 	/* default is YAPF type 2 */
-	typedef Trackdir (*PfnChooseRailTrack)(const Train*, TileIndex, DiagDirection, TrackBits, bool&, bool, PBSTileInfo*);
+	typedef Trackdir (*PfnChooseRailTrack)(const Train*, TileIndex, DiagDirection, TrackBits, bool&, bool, PBSTileInfo*, TrainPathCache*);
 	PfnChooseRailTrack pfnChooseRailTrack = &CYapfRail1::stChooseRailTrack;
 
 	/* check if non-default YAPF type needed */
@@ -659,7 +678,7 @@ Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdi
 		pfnChooseRailTrack = &CYapfRail2::stChooseRailTrack; // Trackdir, forbid 90-deg
 	}
 
-	Trackdir td_ret = pfnChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target);
+	Trackdir td_ret = pfnChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, path_cache);
 	return (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : FindFirstTrack(tracks);
 }
 
@@ -722,6 +741,11 @@ bool YapfTrainCheckReverse(const Train *v)
 	return reverse;
 }
 
+/** Distances to the nearest depots for servicing trains, with 90 degree turns allowed. */
+static CDepotDistanceCacheT<CFollowTrackRail> _rail_depot_distances;
+/** Distances to the nearest depots for servicing trains, with 90 degree turns forbidden. */
+static CDepotDistanceCacheT<CFollowTrackRailNo90> _rail_depot_distances_no90;
+
 FindDepotData YapfTrainFindNearestDepot(const Train *v, int max_penalty)
 {
 	FindDepotData fdd;
@@ -729,6 +753,22 @@ FindDepotData YapfTrainFindNearestDepot(const Train *v, int max_penalty)
 	const Train *last_veh = v->Last();
 
 	PBSTileInfo origin = FollowTrainReservation(v);
+
+	/* Only servicing limits the distance; a table of all depots at any distance would be too large.
+	 * Reversing is not considered, just like the search below does not with its infinite reverse penalty. */
+	if (_settings_game.pf.yapf.cache_depot_distances && max_penalty > 0) {
+		if (_settings_game.pf.forbid_90_deg) {
+			CFollowTrackRailNo90 ft(v->owner, v->compatible_railtypes);
+			fdd = _rail_depot_distances_no90.FindNearestDepot(ft, v->owner, v->compatible_railtypes, max_penalty, origin.tile, origin.trackdir);
+		} else {
+			CFollowTrackRail ft(v->owner, v->compatible_railtypes);
+			fdd = _rail_depot_distances.FindNearestDepot(ft, v->owner, v->compatible_railtypes, max_penalty, origin.tile, origin.trackdir);
+		}
+		/* Same fake distance as the search below returns. */
+		if (fdd.best_length != UINT_MAX) fdd.best_length = max_penalty / 2;
+		return fdd;
+	}
+
 	TileIndex last_tile = last_veh->tile;
 	Trackdir td_rev = ReverseTrackdir(last_veh->GetVehicleTrackdir());
 
@@ -776,8 +816,28 @@ void YapfTrainStationsToTarget(const Train *v, bool &path_found, PBSTileInfo *ta
 
 /** if any track changes, this counter is incremented - that will invalidate segment cost cache */
 int CSegmentCostCacheBase::s_rail_change_counter = 0;
+int CSegmentCostCacheBase::s_rail_flush_counter = 0;
+CSegmentCostCacheArea CSegmentCostCacheBase::s_changed_areas[CSegmentCostCacheBase::C_CHANGE_LOG_SIZE];
+uint CSegmentCostCacheBase::s_hits = 0;
+uint CSegmentCostCacheBase::s_misses = 0;
+uint CSegmentCostCacheBase::s_evicted = 0;
+uint CSegmentCostCacheBase::s_flushes = 0;
 
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track)
 {
+	MarkReservationsChanged();
+	InvalidateSignalSegments();
+
+	bool new_depot = tile != INVALID_TILE && IsRailDepotTile(tile);
+	_rail_depot_distances.Invalidate(tile, new_depot);
+	_rail_depot_distances_no90.Invalidate(tile, new_depot);
+
 	CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, track);
+	/* Segments in front of the other end of a tunnel or bridge change as well. */
+	if (tile != INVALID_TILE && IsTileType(tile, MP_TUNNELBRIDGE)) {
+		TileIndex other_end = GetOtherTunnelBridgeEnd(tile);
+		_rail_depot_distances.Invalidate(other_end, false);
+		_rail_depot_distances_no90.Invalidate(other_end, false);
+		CSegmentCostCacheBase::NotifyTrackLayoutChange(other_end, track);
+	}
 }
@@ -13,6 +13,9 @@
 #include "yapf.hpp"
 #include "yapf_node_road.hpp"
 #include "../../roadstop_base.h"
+#include "../path_regions.h"
+#include "../depot_distance.hpp"
+#include "yapf_cache.h"
 
 #include "../../safeguards.h"
 
@@ -206,6 +209,48 @@ public:
 };
 
 
+/** Number of regions a road vehicle is guided ahead when road_use_regions is set. */
+static const uint ROAD_REGION_LOOKAHEAD = 4;
+/** Maximum number of patches the region search looks at. */
+static const uint ROAD_REGION_MAX_NODES = 10000;
+
+/**
+ * Get the sides of a tile a road type leaves it through.
+ * @param tile The tile.
+ * @param rt The RoadType.
+ * @return Bit mask of DiagDirection.
+ */
+static uint GetRoadRegionSides(TileIndex tile, uint rt)
+{
+	RoadBits bits = GetAnyRoadBits(tile, (RoadType)rt, true);
+	uint sides = 0;
+	for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+		if ((bits & DiagDirToRoadBits(dir)) != ROAD_NONE) SetBit(sides, dir);
+	}
+	return sides;
+}
+
+/** Connectivity of the road network of each road type. */
+static PathRegionMap _road_regions[ROADTYPE_END] = {
+	PathRegionMap(&GetRoadRegionSides, ROADTYPE_ROAD),
+	PathRegionMap(&GetRoadRegionSides, ROADTYPE_TRAM),
+};
+
+/** Distances to the nearest depots for servicing road vehicles. */
+static CDepotDistanceCacheT<CFollowTrackRoad> _road_depot_distances;
+
+void YapfNotifyRoadLayoutChange(TileIndex tile)
+{
+	_road_depot_distances.Invalidate(tile, tile != INVALID_TILE && IsRoadDepotTile(tile));
+	for (RoadType rt = ROADTYPE_BEGIN; rt < ROADTYPE_END; rt++) {
+		if (tile == INVALID_TILE) {
+			_road_regions[rt].InvalidateAll();
+		} else {
+			_road_regions[rt].Invalidate(tile);
+		}
+	}
+}
+
 template <class Types>
 class CYapfDestinationTileRoadT
 {
@@ -221,10 +266,17 @@ protected:
 	StationID    m_dest_station;
 	bool         m_bus;
 	bool         m_non_artic;
+	bool         m_use_region;    ///< whether to search for #m_region_dest instead of the destination itself
+	RoadType     m_roadtype;      ///< road type of the vehicle, for looking up #m_region_dest
+	PathRegionPatch m_region_dest; ///< intermediate destination on the way to the destination
+	TileArea     m_region_area;   ///< area of the region of #m_region_dest
 
 public:
+	CYapfDestinationTileRoadT() : m_use_region(false) {}
+
 	void SetDestination(const RoadVehicle *v)
 	{
+		m_use_region = false;
 		if (v->current_order.IsType(OT_GOTO_STATION)) {
 			m_dest_station  = v->current_order.GetDestination();
 			m_bus           = v->IsBus();
@@ -238,6 +290,50 @@ public:
 		}
 	}
 
+	/**
+	 * Replace a far away destination by a region on the way to it, so the
+	 * search only needs to cover the first part of the route.
+	 * SetDestination() has to be called first.
+	 * @param v the vehicle
+	 * @param tile the tile the search starts at
+	 * @return whether an intermediate destination is used
+	 */
+	bool SetRegionDestination(const RoadVehicle *v, TileIndex tile)
+	{
+		PathRegionMap &regions = _road_regions[v->roadtype];
+		PathRegionPatch start;
+		if (!regions.GetPatch(tile, &start)) return false;
+
+		SmallVector<PathRegionPatch, 8> goals;
+		PathRegionPatch goal;
+		if (m_dest_station != INVALID_STATION) {
+			const Station *st = Station::Get(m_dest_station);
+			for (const RoadStop *rs = st->GetPrimaryRoadStop(m_bus ? ROADSTOP_BUS : ROADSTOP_TRUCK); rs != NULL; rs = rs->next) {
+				if (!m_non_artic && !IsDriveThroughStopTile(rs->xy)) continue;
+				if (regions.GetPatch(rs->xy, &goal)) goals.Include(goal);
+			}
+		} else if (regions.GetPatch(m_destTile, &goal)) {
+			*goals.Append() = goal;
+		}
+
+		/* An unreachable destination is left to the normal search, so vehicles behave as before. */
+		PathRegionPath path;
+		if (!regions.FindPath(start, goals.Begin(), goals.Length(), &path, ROAD_REGION_MAX_NODES)) return false;
+		if (path.Length() <= ROAD_REGION_LOOKAHEAD + 1) return false;
+
+		m_use_region  = true;
+		m_roadtype    = v->roadtype;
+		m_region_dest = path[ROAD_REGION_LOOKAHEAD];
+		m_region_area = regions.GetRegionArea(m_region_dest.region);
+		return true;
+	}
+
+	/** Whether the search goes to an intermediate destination set by SetRegionDestination(). */
+	inline bool UsesRegionDestination() const
+	{
+		return m_use_region;
+	}
+
 protected:
 	/** to access inherited path finder */
 	Tpf& Yapf()
@@ -254,6 +350,8 @@ public:
 
 	inline bool PfDetectDestinationTile(TileIndex tile, Trackdir trackdir)
 	{
+		if (m_use_region) return _road_regions[m_roadtype].IsInPatch(tile, m_region_dest);
+
 		if (m_dest_station != INVALID_STATION) {
 			return IsTileType(tile, MP_STATION) &&
 				GetStationIndex(tile) == m_dest_station &&
@@ -283,6 +381,13 @@ public:
 		int y1 = 2 * TileY(tile) + dg_dir_to_y_offs[(int)exitdir];
 		int x2 = 2 * TileX(m_destTile);
 		int y2 = 2 * TileY(m_destTile);
+		if (m_use_region) {
+			/* Estimate the distance to the closest tile of the region. */
+			int x = TileX(m_region_area.tile);
+			int y = TileY(m_region_area.tile);
+			x2 = Clamp(x1, 2 * x, 2 * (x + m_region_area.w - 1));
+			y2 = Clamp(y1, 2 * y, 2 * (y + m_region_area.h - 1));
+		}
 		int dx = abs(x1 - x2);
 		int dy = abs(y1 - y2);
 		int dmin = min(dx, dy);
@@ -335,11 +440,26 @@ public:
 
 	static Trackdir stChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, bool &path_found)
 	{
+		if (_settings_game.pf.yapf.road_use_regions) {
+			Tpf pf;
+			Trackdir td = pf.ChooseRoadTrack(v, tile, enterdir, path_found, true);
+			/* When the intermediate destination cannot be reached, search the whole way. */
+			if (path_found || !pf.UsesRegionDestination()) return td;
+		}
 		Tpf pf;
-		return pf.ChooseRoadTrack(v, tile, enterdir, path_found);
+		return pf.ChooseRoadTrack(v, tile, enterdir, path_found, false);
 	}
 
-	inline Trackdir ChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, bool &path_found)
+	/**
+	 * Choose the trackdir to take at a tile.
+	 * @param v the vehicle
+	 * @param tile the tile the vehicle enters
+	 * @param enterdir the side the vehicle enters the tile from
+	 * @param[out] path_found whether a path to the destination has been found
+	 * @param use_regions whether a far away destination may be replaced by a region on the way to it
+	 * @return the trackdir to take, or INVALID_TRACKDIR
+	 */
+	inline Trackdir ChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, bool &path_found, bool use_regions)
 	{
 		/* Handle special case - when next tile is destination tile.
 		 * However, when going to a station the (initial) destination
@@ -359,6 +479,7 @@ public:
 		/* set origin and destination nodes */
 		Yapf().SetOrigin(src_tile, src_trackdirs);
 		Yapf().SetDestination(v);
+		if (use_regions) Yapf().SetRegionDestination(v, src_tile);
 
 		/* find the best path */
 		path_found = Yapf().FindPath(v);
@@ -508,6 +629,12 @@ FindDepotData YapfRoadVehicleFindNearestDepot(const RoadVehicle *v, int max_dist
 		return FindDepotData();
 	}
 
+	/* Only servicing limits the distance; a table of all depots at any distance would be too large. */
+	if (_settings_game.pf.yapf.cache_depot_distances && max_distance > 0) {
+		CFollowTrackRoad ft(v);
+		return _road_depot_distances.FindNearestDepot(ft, v->owner, v->compatible_roadtypes, max_distance, tile, trackdir);
+	}
+
 	/* default is YAPF type 2 */
 	typedef FindDepotData (*PfnFindNearestDepot)(const RoadVehicle*, TileIndex, Trackdir, int);
 	PfnFindNearestDepot pfnFindNearestDepot = &CYapfRoadAnyDepot2::stFindNearestDepot;
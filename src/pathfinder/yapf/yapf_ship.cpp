@@ -14,9 +14,132 @@
 
 #include "yapf.hpp"
 #include "yapf_node_ship.hpp"
+#include "yapf_cache.h"
+#include "../path_regions.h"
 
 #include "../../safeguards.h"
 
+/** Number of regions a ship is guided ahead when ship_use_regions is set. */
+static const uint SHIP_REGION_LOOKAHEAD = 4;
+/** Maximum number of patches the region search looks at. */
+static const uint SHIP_REGION_MAX_NODES = 10000;
+
+/**
+ * Get the sides of a tile ships leave it through.
+ * @param tile The tile.
+ * @return Bit mask of DiagDirection.
+ */
+static uint GetWaterRegionSides(TileIndex tile, uint)
+{
+	TrackdirBits trackdirs = TrackStatusToTrackdirBits(GetTileTrackStatus(tile, TRANSPORT_WATER, 0));
+	uint sides = 0;
+	while (trackdirs != TRACKDIR_BIT_NONE) SetBit(sides, TrackdirToExitdir(RemoveFirstTrackdir(&trackdirs)));
+	return sides;
+}
+
+/** Connectivity of all water ships can sail on. */
+static PathRegionMap _water_regions(&GetWaterRegionSides, 0);
+
+void YapfNotifyWaterLayoutChange(TileIndex tile)
+{
+	if (tile == INVALID_TILE) {
+		_water_regions.InvalidateAll();
+	} else {
+		_water_regions.Invalidate(tile);
+	}
+}
+
+/** Destination module of YAPF for ships, which can replace a far away destination by a region on the way to it. */
+template <class Types>
+class CYapfDestinationTileShipT : public CYapfDestinationTileT<Types>
+{
+public:
+	typedef CYapfDestinationTileT<Types> Tbase;   ///< the destination module for a tile
+	typedef typename Types::NodeList::Titem Node; ///< this will be our node type
+
+protected:
+	bool            m_use_region;  ///< whether to search for #m_region_dest instead of the destination tile
+	PathRegionPatch m_region_dest; ///< intermediate destination on the way to the destination tile
+	TileArea        m_region_area; ///< area of the region of #m_region_dest
+
+public:
+	CYapfDestinationTileShipT() : m_use_region(false) {}
+
+	/**
+	 * Replace a far away destination by a region on the way to it, so the
+	 * search only needs to cover the first part of the route.
+	 * SetDestination() has to be called first.
+	 * @param tile the tile the search starts at
+	 * @return whether an intermediate destination is used
+	 */
+	bool SetRegionDestination(TileIndex tile)
+	{
+		PathRegionPatch start;
+		if (!_water_regions.GetPatch(tile, &start)) return false;
+
+		/* Docks are not part of the water themselves; go to the water next to them. */
+		SmallVector<PathRegionPatch, 4> goals;
+		PathRegionPatch goal;
+		if (_water_regions.GetPatch(this->m_destTile, &goal)) {
+			*goals.Append() = goal;
+		} else {
+			for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+				TileIndex t = AddTileIndexDiffCWrap(this->m_destTile, TileIndexDiffCByDiagDir(dir));
+				if (t != INVALID_TILE && _water_regions.GetPatch(t, &goal)) goals.Include(goal);
+			}
+		}
+
+		PathRegionPath path;
+		if (!_water_regions.FindPath(start, goals.Begin(), goals.Length(), &path, SHIP_REGION_MAX_NODES)) return false;
+		if (path.Length() <= SHIP_REGION_LOOKAHEAD + 1) return false;
+
+		m_use_region  = true;
+		m_region_dest = path[SHIP_REGION_LOOKAHEAD];
+		m_region_area = _water_regions.GetRegionArea(m_region_dest.region);
+		return true;
+	}
+
+	/** Called by YAPF to detect if node ends in the desired destination */
+	inline bool PfDetectDestination(Node &n)
+	{
+		if (!m_use_region) return Tbase::PfDetectDestination(n);
+		return _water_regions.IsInPatch(n.GetTile(), m_region_dest);
+	}
+
+	/**
+	 * Called by YAPF to calculate cost estimate. Calculates distance to the destination
+	 *  adds it to the actual cost from origin and stores the sum to the Node::m_estimate
+	 */
+	inline bool PfCalcEstimate(Node &n)
+	{
+		static const int dg_dir_to_x_offs[] = {-1, 0, 1, 0};
+		static const int dg_dir_to_y_offs[] = {0, 1, 0, -1};
+		if (!m_use_region) return Tbase::PfCalcEstimate(n);
+		if (PfDetectDestination(n)) {
+			n.m_estimate = n.m_cost;
+			return true;
+		}
+
+		/* Estimate the distance to the closest tile of the region. */
+		TileIndex tile = n.GetTile();
+		DiagDirection exitdir = TrackdirToExitdir(n.GetTrackdir());
+		int x1 = 2 * TileX(tile) + dg_dir_to_x_offs[(int)exitdir];
+		int y1 = 2 * TileY(tile) + dg_dir_to_y_offs[(int)exitdir];
+		int x = TileX(m_region_area.tile);
+		int y = TileY(m_region_area.tile);
+		int x2 = Clamp(x1, 2 * x, 2 * (x + m_region_area.w - 1));
+		int y2 = Clamp(y1, 2 * y, 2 * (y + m_region_area.h - 1));
+		int dx = abs(x1 - x2);
+		int dy = abs(y1 - y2);
+		int dmin = min(dx, dy);
+		int dxy = abs(dx - dy);
+		int d = dmin * YAPF_TILE_CORNER_LENGTH + (dxy - 1) * (YAPF_TILE_LENGTH / 2);
+		n.m_estimate = n.m_cost + d;
+		assert(n.m_estimate >= n.m_parent->m_estimate);
+		return true;
+	}
+};
+
 /** Node Follower module of YAPF for ships */
 template <class Types>
 class CYapfFollowShipT
@@ -73,8 +196,21 @@ public:
 		Trackdir trackdir = v->GetVehicleTrackdir();
 		assert(IsValidTrackdir(trackdir));
 
-		/* convert origin trackdir to TrackdirBits */
-		TrackdirBits trackdirs = TrackdirToTrackdirBits(trackdir);
+		return FindShipTrack(v, tile, src_tile, TrackdirToTrackdirBits(trackdir), _settings_game.pf.yapf.ship_use_regions, path_found);
+	}
+
+	/**
+	 * Search the trackdir a ship has to take at the next tile.
+	 * @param v the ship
+	 * @param tile the tile the ship enters
+	 * @param src_tile the tile the ship comes from
+	 * @param trackdirs the trackdirs the ship may have on \a src_tile
+	 * @param use_regions whether a far away destination may be replaced by a region on the way to it
+	 * @param[out] path_found whether a path to the destination has been found
+	 * @return the trackdir to take at \a tile, or INVALID_TRACKDIR
+	 */
+	static Trackdir FindShipTrack(const Ship *v, TileIndex tile, TileIndex src_tile, TrackdirBits trackdirs, bool use_regions, bool &path_found)
+	{
 		/* get available trackdirs on the destination tile */
 		TrackdirBits dest_trackdirs = TrackStatusToTrackdirBits(GetTileTrackStatus(v->dest_tile, TRANSPORT_WATER, 0));
 
@@ -83,8 +219,14 @@ public:
 		/* set origin and destination nodes */
 		pf.SetOrigin(src_tile, trackdirs);
 		pf.SetDestination(v->dest_tile, dest_trackdirs);
-		/* find best path */
-		path_found = pf.FindPath(v);
+		if (use_regions && pf.SetRegionDestination(src_tile)) {
+			path_found = pf.FindPath(v);
+			/* When the intermediate destination cannot be reached, search the whole way. */
+			if (!path_found) return FindShipTrack(v, tile, src_tile, trackdirs, false, path_found);
+		} else {
+			/* find best path */
+			path_found = pf.FindPath(v);
+		}
 
 		Trackdir next_trackdir = INVALID_TRACKDIR; // this would mean "path not found"
 
@@ -209,7 +351,7 @@ struct CYapfShip_TypesT
 	typedef CYapfBaseT<Types>                 PfBase;        // base pathfinder class
 	typedef CYapfFollowShipT<Types>           PfFollow;      // node follower
 	typedef CYapfOriginTileT<Types>           PfOrigin;      // origin provider
-	typedef CYapfDestinationTileT<Types>      PfDestination; // destination/distance provider
+	typedef CYapfDestinationTileShipT<Types>  PfDestination; // destination/distance provider
 	typedef CYapfSegmentCostCacheNoneT<Types> PfCache;       // segment cost cache provider
 	typedef CYapfCostShipT<Types>             PfCost;        // cost provider
 };
@@ -17,6 +17,8 @@
 
 #include "safeguards.h"
 
+uint32 _reservation_version; ///< Changes whenever a reservation or the track layout changes.
+
 /**
  * Get the reserved trackbits for any tile, regardless of type.
  * @param t the tile
@@ -64,6 +66,7 @@ void SetRailStationPlatformReservation(TileIndex start, DiagDirection dir, bool
 	assert(IsRailStationTile(start));
 	assert(GetRailStationAxis(start) == DiagDirToAxis(dir));
 
+	MarkReservationsChanged();
 	do {
 		SetRailStationReservation(tile, b);
 		MarkTileDirtyByTile(tile);
@@ -94,10 +97,15 @@ bool TryReserveRailTrack(TileIndex tile, Track t, bool trigger_stations)
 
 	switch (GetTileType(tile)) {
 		case MP_RAILWAY:
-			if (IsPlainRail(tile)) return TryReserveTrack(tile, t);
+			if (IsPlainRail(tile)) {
+				if (!TryReserveTrack(tile, t)) return false;
+				MarkReservationsChanged();
+				return true;
+			}
 			if (IsRailDepot(tile)) {
 				if (!HasDepotReservation(tile)) {
 					SetDepotReservation(tile, true);
+					MarkReservationsChanged();
 					MarkTileDirtyByTile(tile); // some GRFs change their appearance when tile is reserved
 					return true;
 				}
@@ -107,6 +115,7 @@ bool TryReserveRailTrack(TileIndex tile, Track t, bool trigger_stations)
 		case MP_ROAD:
 			if (IsLevelCrossing(tile) && !HasCrossingReservation(tile)) {
 				SetCrossingReservation(tile, true);
+				MarkReservationsChanged();
 				BarCrossing(tile);
 				MarkTileDirtyByTile(tile); // crossing barred, make tile dirty
 				return true;
@@ -116,6 +125,7 @@ bool TryReserveRailTrack(TileIndex tile, Track t, bool trigger_stations)
 		case MP_STATION:
 			if (HasStationRail(tile) && !HasStationReservation(tile)) {
 				SetRailStationReservation(tile, true);
+				MarkReservationsChanged();
 				if (trigger_stations && IsRailStation(tile)) TriggerStationRandomisation(NULL, tile, SRT_PATH_RESERVATION);
 				MarkTileDirtyByTile(tile); // some GRFs need redraw after reserving track
 				return true;
@@ -125,6 +135,7 @@ bool TryReserveRailTrack(TileIndex tile, Track t, bool trigger_stations)
 		case MP_TUNNELBRIDGE:
 			if (GetTunnelBridgeTransportType(tile) == TRANSPORT_RAIL && !GetTunnelBridgeReservationTrackBits(tile)) {
 				SetTunnelBridgeReservation(tile, true);
+				MarkReservationsChanged();
 				return true;
 			}
 			break;
@@ -152,6 +163,7 @@ void UnreserveRailTrack(TileIndex tile, Track t)
 		}
 	}
 
+	MarkReservationsChanged();
 	switch (GetTileType(tile)) {
 		case MP_RAILWAY:
 			if (IsRailDepot(tile)) {
@@ -298,8 +310,23 @@ PBSTileInfo FollowTrainReservation(const Train *v, Vehicle **train_on_res)
 	if (IsRailDepotTile(tile) && !GetDepotReservationTrackBits(tile)) return PBSTileInfo(tile, trackdir, false);
 
 	FindTrainOnTrackInfo ftoti;
-	ftoti.res = FollowReservation(v->owner, GetRailTypeInfo(v->railtype)->compatible_railtypes, tile, trackdir);
-	ftoti.res.okay = IsSafeWaitingPosition(v, ftoti.res.tile, ftoti.res.trackdir, true, _settings_game.pf.forbid_90_deg);
+	TrainReservationCache &cache = v->reservation_cache;
+	if (cache.version == _reservation_version && cache.start == tile && cache.start_td == trackdir &&
+			cache.owner == v->owner && cache.railtype == v->railtype && cache.forbid_90deg == _settings_game.pf.forbid_90_deg) {
+		/* Nothing changed since the reservation was followed the last time. */
+		ftoti.res = cache.end;
+	} else {
+		ftoti.res = FollowReservation(v->owner, GetRailTypeInfo(v->railtype)->compatible_railtypes, tile, trackdir);
+		ftoti.res.okay = IsSafeWaitingPosition(v, ftoti.res.tile, ftoti.res.trackdir, true, _settings_game.pf.forbid_90_deg);
+
+		cache.start = tile;
+		cache.start_td = trackdir;
+		cache.owner = v->owner;
+		cache.railtype = v->railtype;
+		cache.forbid_90deg = _settings_game.pf.forbid_90_deg;
+		cache.version = _reservation_version;
+		cache.end = ftoti.res;
+	}
 	if (train_on_res != NULL) {
 		FindVehicleOnPos(ftoti.res.tile, &ftoti, FindTrainOnTrackEnum);
 		if (ftoti.best != NULL) *train_on_res = ftoti.best->First();
@@ -17,6 +17,17 @@
 #include "track_type.h"
 #include "vehicle_type.h"
 
+extern uint32 _reservation_version;
+
+/**
+ * Note that a track reservation or the track layout changed, so the cached
+ * reservation ends of all trains are outdated.
+ */
+static inline void MarkReservationsChanged()
+{
+	_reservation_version++;
+}
+
 TrackBits GetReservedTrackbits(TileIndex t);
 
 void SetRailStationPlatformReservation(TileIndex start, DiagDirection dir, bool b);
@@ -690,6 +690,7 @@ CommandCost CmdRemoveSingleRail(TileIndex tile, DoCommandFlag flags, uint32 p1,
 					/* If there is flat water on the lower halftile, convert the tile to shore so the water remains */
 					if (GetRailGroundType(tile) == RAIL_GROUND_WATER && IsSlopeWithOneCornerRaised(tileh)) {
 						MakeShore(tile);
+						YapfNotifyWaterLayoutChange(tile);
 					} else {
 						DoClearSquare(tile);
 					}
@@ -761,6 +762,7 @@ bool FloodHalftile(TileIndex t)
 			if (rail_bits == 0) {
 				MakeShore(t);
 				MarkTileDirtyByTile(t);
+				YapfNotifyWaterLayoutChange(t);
 				return flooded;
 			}
 		}
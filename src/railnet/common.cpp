@@ -182,6 +182,422 @@ RailnetOfile& RailnetOfile::operator<<(const CargoLabelT& c)
 	return *this << lbl_conv.Convert(c);
 }
 
+namespace {
+
+//! fills the railnet structures from a JsonPullParser
+class RailnetReader : public RailnetStrings
+{
+	JsonPullParser p;
+
+	bool Is(const StrView& key, StrId id) { return key == StringNo(id); }
+
+	void Read(bool& b) { b = p.Bool(); }
+	void Read(int& i) { i = p.Integer<int>(); }
+	void Read(unsigned char& c) { c = p.Integer<unsigned char>(); }
+	void Read(uint16& i) { i = p.Integer<uint16>(); }
+	void Read(float& f) { f = p.Float(); }
+	void Read(std::string& s) { StrView v = p.String(); s.assign(v.data(), v.size()); }
+
+	void Read(CargoLabelT& c)
+	{
+		static LblConvT lbl_conv;
+		StrView v = p.String();
+		if(v.size() != 4)
+		 throw "cargo labels must have 4 characters";
+		c = lbl_conv.Convert(v.data());
+	}
+
+	template<class T, std::size_t S>
+	void Read(SMem<T, S>& s) { Read(s.Get()); }
+
+	template<class T1, class T2>
+	void Read(std::pair<T1, T2>& pr)
+	{
+		p.BeginArray();
+		if(!p.NextElement())
+		 throw "expected pair";
+		Read(pr.first);
+		if(!p.NextElement())
+		 throw "expected pair";
+		Read(pr.second);
+		if(p.NextElement())
+		 throw "expected ']' after pair";
+	}
+
+	template<class T>
+	void Read(std::vector<T>& v)
+	{
+		p.BeginArray();
+		while(p.NextElement())
+		{
+			v.emplace_back();
+			Read(v.back());
+		}
+	}
+
+	template<class K, class V>
+	void Read(std::map<K, V>& m)
+	{
+		p.BeginArray();
+		while(p.NextElement())
+		{
+			std::pair<K, V> pr;
+			Read(pr);
+			m.emplace_hint(m.end(), std::move(pr));
+		}
+	}
+
+	void Read(CargoInfo& ci)
+	{
+		StrView key;
+		p.BeginObject();
+		while(p.NextKey(&key))
+		{
+			if(Is(key, S_FWD)) Read(ci.fwd);
+			else if(Is(key, S_REV)) Read(ci.rev);
+			else if(Is(key, S_SLICE)) Read(ci.slice);
+			else throw "unknown key";
+		}
+	}
+
+	void Read(OrderList& ol)
+	{
+		StrView key;
+		p.BeginObject();
+		while(p.NextKey(&key))
+		{
+			if(Is(key, S_IS_CYCLE)) Read(ol.is_cycle);
+			else if(Is(key, S_CARGO)) Read(ol.cargo);
+			else if(Is(key, S_STATIONS)) Read(ol.stations);
+			else if(Is(key, S_UNIT_NUMBER)) Read(ol.unit_number);
+			else if(Is(key, S_REV_UNIT_NO)) Read(ol.rev_unit_no);
+			else throw "unknown key";
+		}
+	}
+
+	void Read(StationInfo& si)
+	{
+		StrView key;
+		p.BeginObject();
+		while(p.NextKey(&key))
+		{
+			if(Is(key, S_NAME)) Read(si.name);
+			else if(Is(key, S_X)) Read(si.x);
+			else if(Is(key, S_Y)) Read(si.y);
+			else throw "unknown key";
+		}
+	}
+
+public:
+	RailnetReader(StrView buf) : p(buf) {}
+
+	void Read(RailnetFileInfo& fi)
+	{
+		StrView key;
+		p.BeginObject();
+		while(p.NextKey(&key))
+		{
+			if(Is(key, S_MIMETYPE)) {
+				if(p.String() != fi.hdr().c_str())
+				 throw "header signature does not match";
+			}
+			else if(Is(key, S_VERSION)) {
+				if(p.Integer<int>() != fi.version)
+				 throw "version mismatch";
+			}
+			else if(Is(key, S_ORDER_LISTS)) Read(fi.order_lists);
+			else if(Is(key, S_STATIONS)) Read(fi.stations);
+			else if(Is(key, S_CARGO_NAMES)) Read(fi.cargo_names);
+			else throw "unknown key";
+		}
+		if(!p.AtEnd())
+		 throw "trailing characters after railnet file";
+	}
+};
+
+//! magic bytes at the beginning of binary railnet files
+const char binary_magic[8] = { 'R', 'N', 'E', 'T', 'B', 'I', 'N', 0 };
+//! version of the binary layout, independent of the railnet version
+const uint32 binary_version = 1;
+
+//! collects the binary representation of a railnet file
+class BinaryWriter
+{
+	std::vector<char> buf;
+	std::vector<const std::string*> strings;
+	std::map<std::string, uint32> string_ids;
+public:
+	void U8(uint8_t v) { buf.push_back(v); }
+	void U16(uint16_t v) { U8(v & 0xFF); U8(v >> 8); }
+	void U32(uint32_t v) { U16(v & 0xFFFF); U16(v >> 16); }
+	void I32(int32_t v) { U32(v); }
+	void F32(float f) { uint32_t v; std::memcpy(&v, &f, 4); U32(v); }
+	void Raw(const char* s, std::size_t len) { buf.insert(buf.end(), s, s + len); }
+
+	//! @return the index of @a s in the string table, adding it if needed
+	uint32 String(const std::string& s)
+	{
+		auto res = string_ids.emplace(s, strings.size());
+		if(res.second)
+		 strings.push_back(&res.first->first);
+		return res.first->second;
+	}
+
+	void WriteStrings()
+	{
+		uint32 offset = 0;
+		for(const std::string* s : strings)
+		{
+			U32(offset);
+			offset += s->size();
+		}
+		U32(offset);
+		for(const std::string* s : strings)
+		 Raw(s->data(), s->size());
+	}
+
+	std::size_t StringCount() const { return strings.size(); }
+	const std::vector<char>& Buffer() const { return buf; }
+};
+
+//! reads the binary representation of a railnet file
+class BinaryReader
+{
+	const char* pos;
+	const char* const end;
+
+	const char* Take(std::size_t n)
+	{
+		if(std::size_t(end - pos) < n)
+		 throw "unexpected end of file";
+		const char* res = pos;
+		pos += n;
+		return res;
+	}
+
+	uint32 string_count = 0;
+	const char* string_offsets = NULL;
+	const char* string_chars = NULL;
+	uint32 string_size = 0;
+public:
+	BinaryReader(StrView buf) : pos(buf.data()), end(buf.data() + buf.size()) {}
+
+	uint8_t U8() { return *Take(1); }
+	uint16_t U16() { const unsigned char* p = (const unsigned char*)Take(2); return p[0] | (p[1] << 8); }
+	uint32_t U32() { uint32_t lo = U16(); return lo | ((uint32_t)U16() << 16); }
+	int32_t I32() { return (int32_t)U32(); }
+	float F32() { uint32_t v = U32(); float f; std::memcpy(&f, &v, 4); return f; }
+	void Skip(std::size_t n) { Take(n); }
+	bool AtEnd() const { return pos == end; }
+
+	void ReadStrings(uint32 count)
+	{
+		string_count = count;
+		string_offsets = Take((count + 1) * 4ul);
+		BinaryReader offsets(StrView(string_offsets + count * 4ul, 4));
+		string_size = offsets.U32();
+		string_chars = Take(string_size);
+	}
+
+	StrView String(uint32 id) const
+	{
+		if(id >= string_count)
+		 throw "invalid string index";
+		BinaryReader offsets(StrView(string_offsets + id * 4ul, 8));
+		uint32 begin = offsets.U32(), end = offsets.U32();
+		if(begin > end || end > string_size)
+		 throw "invalid string table";
+		return StrView(string_chars + begin, end - begin);
+	}
+
+	StrView String() { return String(U32()); }
+};
+
+void ReadRailnetBinary(StrView buf, RailnetFileInfo& fi)
+{
+	static LblConvT lbl_conv;
+	BinaryReader r(buf);
+	r.Skip(sizeof(binary_magic));
+	if(r.U32() != binary_version)
+	 throw "unsupported binary railnet version";
+	if(r.I32() != fi.version)
+	 throw "version mismatch";
+
+	uint32 n_strings = r.U32(), n_stations = r.U32(), n_cargo_names = r.U32(),
+		n_order_lists = r.U32(), n_stops = r.U32(), n_cargo = r.U32();
+	r.ReadStrings(n_strings);
+	if(r.String(0) != fi.hdr().c_str())
+	 throw "header signature does not match";
+
+	for(uint32 i = 0; i < n_stations; ++i)
+	{
+		StationID id = r.U16();
+		r.Skip(2);
+		StationInfo& si = fi.stations()[id];
+		StrView name = r.String();
+		si.name().assign(name.data(), name.size());
+		si.x = r.F32();
+		si.y = r.F32();
+	}
+
+	for(uint32 i = 0; i < n_cargo_names; ++i)
+	{
+		unsigned char id = r.U8();
+		r.Skip(3);
+		StrView lbl = r.String();
+		if(lbl.size() != 4)
+		 throw "cargo labels must have 4 characters";
+		fi.cargo_names()[id] = lbl_conv.Convert(lbl.data());
+	}
+
+	// the tables that follow are read in parallel, so read the
+	// order list table first and remember where the others start
+	struct OrderListRecord { uint32 first_stop, stops, first_cargo, cargo; };
+	std::vector<OrderListRecord> records;
+	records.reserve(n_order_lists);
+	fi.order_lists().reserve(fi.order_lists().size() + n_order_lists);
+	for(uint32 i = 0; i < n_order_lists; ++i)
+	{
+		fi.order_lists().emplace_back();
+		OrderList& ol = fi.order_lists().back();
+		ol.unit_number = r.U16();
+		ol.rev_unit_no = r.U16();
+		ol.is_cycle = r.U8();
+		r.Skip(3);
+		OrderListRecord rec;
+		rec.first_stop = r.U32();
+		rec.stops = r.U32();
+		rec.first_cargo = r.U32();
+		rec.cargo = r.U32();
+		if(rec.first_stop > n_stops || rec.stops > n_stops - rec.first_stop
+			|| rec.first_cargo > n_cargo || rec.cargo > n_cargo - rec.first_cargo)
+		 throw "invalid order list record";
+		records.push_back(rec);
+	}
+
+	std::vector<std::pair<StationID, bool>> stops;
+	stops.reserve(n_stops);
+	for(uint32 i = 0; i < n_stops; ++i)
+	{
+		StationID sid = r.U16();
+		bool stop = r.U8();
+		r.Skip(1);
+		stops.emplace_back(sid, stop);
+	}
+
+	std::vector<std::pair<CargoLabelT, CargoInfo>> cargo;
+	cargo.reserve(n_cargo);
+	for(uint32 i = 0; i < n_cargo; ++i)
+	{
+		StrView lbl = r.String();
+		if(lbl.size() != 4)
+		 throw "cargo labels must have 4 characters";
+		CargoInfo ci;
+		ci.slice = r.I32();
+		ci.fwd = r.U8();
+		ci.rev = r.U8();
+		r.Skip(2);
+		cargo.emplace_back(CargoLabelT(lbl_conv.Convert(lbl.data())), ci);
+	}
+	if(!r.AtEnd())
+	 throw "trailing characters after railnet file";
+
+	std::vector<OrderList>::iterator ol = fi.order_lists().end() - n_order_lists;
+	for(const OrderListRecord& rec : records)
+	{
+		ol->stations().assign(stops.begin() + rec.first_stop,
+			stops.begin() + rec.first_stop + rec.stops);
+		ol->cargo().insert(cargo.begin() + rec.first_cargo,
+			cargo.begin() + rec.first_cargo + rec.cargo);
+		++ol;
+	}
+}
+
+}
+
+void ReadRailnetFile(const char* filename, RailnetFileInfo& file)
+{
+	MappedFile mapped(filename);
+	StrView buf = mapped.View();
+	if(buf.size() >= sizeof(binary_magic)
+		&& !std::memcmp(buf.data(), binary_magic, sizeof(binary_magic)))
+	 ReadRailnetBinary(buf, file);
+	else
+	 RailnetReader(buf).Read(file);
+}
+
+void WriteRailnetBinary(std::ostream& os, const RailnetFileInfo& fi)
+{
+	static LblConvT lbl_conv;
+	BinaryWriter strings, tables;
+	strings.String(fi.hdr());
+
+	for(const auto& pr : fi.stations())
+	{
+		tables.U16(pr.first);
+		tables.U16(0);
+		tables.U32(strings.String(pr.second.name()));
+		tables.F32(pr.second.x());
+		tables.F32(pr.second.y());
+	}
+
+	for(const auto& pr : fi.cargo_names())
+	{
+		tables.U8(pr.first);
+		tables.U8(0); tables.U8(0); tables.U8(0);
+		tables.U32(strings.String(lbl_conv.Convert(pr.second)));
+	}
+
+	uint32 n_stops = 0, n_cargo = 0;
+	for(const OrderList& ol : fi.order_lists())
+	{
+		tables.U16(ol.unit_number);
+		tables.U16(ol.rev_unit_no);
+		tables.U8(ol.is_cycle);
+		tables.U8(0); tables.U8(0); tables.U8(0);
+		tables.U32(n_stops);
+		tables.U32(ol.stations().size());
+		tables.U32(n_cargo);
+		tables.U32(ol.cargo().size());
+		n_stops += ol.stations().size();
+		n_cargo += ol.cargo().size();
+	}
+
+	for(const OrderList& ol : fi.order_lists())
+	for(const auto& pr : ol.stations())
+	{
+		tables.U16(pr.first);
+		tables.U8(pr.second);
+		tables.U8(0);
+	}
+
+	for(const OrderList& ol : fi.order_lists())
+	for(const auto& pr : ol.cargo())
+	{
+		tables.U32(strings.String(lbl_conv.Convert(pr.first)));
+		tables.I32(pr.second.slice);
+		tables.U8(pr.second.fwd);
+		tables.U8(pr.second.rev);
+		tables.U16(0);
+	}
+
+	BinaryWriter header;
+	header.Raw(binary_magic, sizeof(binary_magic));
+	header.U32(binary_version);
+	header.I32(fi.version);
+	header.U32(strings.StringCount());
+	header.U32(fi.stations().size());
+	header.U32(fi.cargo_names().size());
+	header.U32(fi.order_lists().size());
+	header.U32(n_stops);
+	header.U32(n_cargo);
+	strings.WriteStrings();
+
+	os.write(header.Buffer().data(), header.Buffer().size());
+	os.write(strings.Buffer().data(), strings.Buffer().size());
+	os.write(tables.Buffer().data(), tables.Buffer().size());
+}
+
 void Prechecks(const RailnetFileInfo& )
 {
 	// FEATURE, not done yet
@@ -186,7 +186,7 @@ struct RailnetFileInfo
 	static constexpr int _version = 0;
 	SMem<std::string, S_MIMETYPE> hdr;
 	SMem<int, S_VERSION> version;
-	SMem<std::list<OrderList>, S_ORDER_LISTS> order_lists;
+	SMem<std::vector<OrderList>, S_ORDER_LISTS> order_lists;
 	SMem<std::map<StationID, StationInfo>, S_STATIONS> stations;
 	/*FEATURE: char suffices, but need short to print it*/
 	SMem<std::map<unsigned char, CargoLabelT>, S_CARGO_NAMES> cargo_names;
@@ -215,7 +215,7 @@ public:
 	self& operator<<(const CargoLabelT& c);
 /*	JsonOfile& operator<<(const std::pair<const char, CargoLabel>& pr);
 	JsonOfile& operator<<(const std::pair<CargoLabel, CargoInfo>& pr);*/
-	RailnetOfile(std::ostream& os) : JsonOfile(*this, os) {}
+	RailnetOfile(std::ostream& os, bool compact = false) : JsonOfile(*this, os, compact) {}
 };
 
 class RailnetIfile : public JsonIfile<RailnetIfile>, public RailnetStrings
@@ -240,6 +240,39 @@ public:
 	RailnetIfile(std::istream& is) : JsonIfile(*this, is) {}
 };
 
+/**
+ * Reads a railnet file through a memory mapping of it, which is much
+ * faster and needs less memory than reading it with RailnetIfile.
+ * Both json and binary files are accepted.
+ * @param filename the file to read
+ * @param file where the file's contents are stored
+ * @throw const char* on any error
+ */
+void ReadRailnetFile(const char* filename, RailnetFileInfo& file);
+
+/**
+ * Writes a railnet file in the binary format. All numbers are little
+ * endian, all tables consist of fixed-width records:
+ *  - header: magic "RNETBIN\0", binary layout version (uint32),
+ *    RailnetFileInfo::version (int32)
+ *  - counts (uint32 each): strings, stations, cargo names, order lists,
+ *    stops, cargo entries
+ *  - string table: offsets (uint32, one more than strings), followed
+ *    by the characters of all strings; string 0 is the mimetype
+ *  - stations: id (uint16), padding (uint16), name (uint32 string),
+ *    x (float), y (float)
+ *  - cargo names: id (uint8), padding (3 bytes), label (uint32 string)
+ *  - order lists: unit number (uint16), reverse unit number (uint16),
+ *    is cycle (uint8), padding (3 bytes), first stop (uint32),
+ *    stops (uint32), first cargo entry (uint32), cargo entries (uint32)
+ *  - stops: station (uint16), train stops (uint8), padding (uint8)
+ *  - cargo entries: label (uint32 string), slice (int32), fwd (uint8),
+ *    rev (uint8), padding (uint16)
+ * @param os the stream to write to
+ * @param file the railnet data
+ */
+void WriteRailnetBinary(std::ostream& os, const RailnetFileInfo& file);
+
 //! @a yet unused
 void Prechecks(const RailnetFileInfo& file);
 
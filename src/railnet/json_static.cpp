@@ -13,8 +13,20 @@
 
 #if __cplusplus >= 201103L || defined(IDE_USED)
 
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iterator>
 #include "json_static.h"
 
+#include <fstream>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 void JsonIfileBase::ReadBool(bool& b, std::istream* is)
 {
 	char tmp[6];
@@ -56,4 +68,139 @@ void JsonIfileBase::ReadCStr(char* s, std::istream* is)
 	}
 }
 
+MappedFile::MappedFile(const char* filename)
+{
+#ifndef _WIN32
+	int fd = open(filename, O_RDONLY);
+	if(fd < 0)
+	 throw "can not open file";
+	struct stat st;
+	if(fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(addr != MAP_FAILED)
+		{
+			// the file is read front to back exactly once
+			madvise(addr, st.st_size, MADV_SEQUENTIAL);
+			_data = static_cast<const char*>(addr);
+			_size = st.st_size;
+			mapped = true;
+		}
+	}
+	close(fd);
+	if(mapped)
+	 return;
+#endif
+	std::ifstream is(filename, std::ios::binary);
+	if(!is)
+	 throw "can not open file";
+	copy.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+	_data = copy.data();
+	_size = copy.size();
+}
+
+MappedFile::~MappedFile()
+{
+#ifndef _WIN32
+	if(mapped)
+	 munmap(const_cast<char*>(_data), _size);
+#endif
+}
+
+char JsonPullParser::Peek()
+{
+	while(pos != end && isspace(*pos))
+	 ++pos;
+	if(pos == end)
+	 throw "unexpected end of file";
+	return *pos;
+}
+
+void JsonPullParser::Expect(char c)
+{
+	if(Peek() != c)
+	 throw "parse error: inexpected char";
+	++pos;
+}
+
+bool JsonPullParser::NextKey(StrView* key)
+{
+	switch(Peek())
+	{
+		case '}':
+			++pos;
+			return false;
+		case ',':
+			++pos;
+			break;
+	}
+	*key = String();
+	Expect(':');
+	return true;
+}
+
+bool JsonPullParser::NextElement()
+{
+	switch(Peek())
+	{
+		case ']':
+			++pos;
+			return false;
+		case ',':
+			++pos;
+			break;
+	}
+	return true;
+}
+
+StrView JsonPullParser::String()
+{
+	Expect('"');
+	const char* begin = pos;
+	const char* quote = static_cast<const char*>(memchr(pos, '"', end - pos));
+	if(!quote)
+	 throw "unexpected end of file";
+	pos = quote + 1;
+	return StrView(begin, quote - begin);
+}
+
+bool JsonPullParser::Bool()
+{
+	Peek();
+	if(end - pos >= 4 && !strncmp(pos, "true", 4))
+	 return pos += 4, true;
+	if(end - pos >= 5 && !strncmp(pos, "false", 5))
+	 return pos += 5, false;
+	throw "boolean must be 'true' or 'false'";
+}
+
+StrView JsonPullParser::Number()
+{
+	Peek();
+	const char* begin = pos;
+	while(pos != end && (isdigit(*pos) || strchr("+-.eE", *pos)))
+	 ++pos;
+	if(pos == begin)
+	 throw "not a number";
+	return StrView(begin, pos - begin);
+}
+
+float JsonPullParser::Float()
+{
+	StrView v = Number();
+	char tmp[64];
+	if(v.size() >= sizeof(tmp))
+	 throw "not a number";
+	std::copy(v.data(), v.data() + v.size(), tmp);
+	tmp[v.size()] = 0;
+	return strtof(tmp, nullptr);
+}
+
+bool JsonPullParser::AtEnd()
+{
+	while(pos != end && isspace(*pos))
+	 ++pos;
+	return pos == end;
+}
+
 #endif // C++11 support
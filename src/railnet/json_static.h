@@ -17,9 +17,13 @@
 #define JSON_STATIC_H
 
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <cmath>
 #include <map>
+#include <string>
+#include <vector>
+#include <type_traits>
 #include <iostream>
 
 namespace detail {
@@ -75,6 +79,8 @@ public:
 };
 
 //! Class to write a JSON formatted file
+//! The output is collected in a buffer and written to the stream
+//! in chunks of about @a flush_size bytes
 template<class Crtp>
 class JsonOfile
 {
@@ -91,6 +97,62 @@ class JsonOfile
 
 	JsonOfile(JsonOfile& other) = delete;
 
+	//! the buffer is written to the stream once it is this large
+	static constexpr std::size_t flush_size = 1 << 20;
+
+	std::ostream* const os;
+	std::vector<char> buf;
+	//! whether to leave out line breaks and indentation
+	const bool compact;
+
+	//! writes structural characters, i.e. no user data
+	void PutRaw(char c)
+	{
+		if(!compact || (c != '\n' && c != ' '))
+		 buf.push_back(c);
+	}
+
+	void PutRaw(const char* s)
+	{
+		for(; *s; ++s) PutRaw(*s);
+	}
+
+	void PutQuoted(const char* s, std::size_t len)
+	{
+		buf.push_back('"');
+		buf.insert(buf.end(), s, s + len);
+		buf.push_back('"');
+	}
+
+	template<class T>
+	void PutUnsigned(T i)
+	{
+		char tmp[24];
+		char* end = tmp + sizeof(tmp);
+		char* pos = end;
+		do { *--pos = '0' + (i % 10); i /= 10; } while(i);
+		buf.insert(buf.end(), pos, end);
+	}
+
+	template<class T>
+	void PutSigned(T i)
+	{
+		if(i < 0) {
+			buf.push_back('-');
+			// negate in the unsigned type, to not overflow for the minimum
+			PutUnsigned(0 - static_cast<typename std::make_unsigned<T>::type>(i));
+		}
+		else PutUnsigned(i);
+	}
+
+	//! to be called after each value
+	Crtp& Done()
+	{
+		if(buf.size() >= flush_size)
+		 Flush();
+		return m;
+	}
+
 protected:
 	class _StructDepth
 	{
@@ -121,25 +183,45 @@ protected:
 
 	friend class StructGuard;
 
-	std::ostream* const os;
 public:
-	JsonOfile(Crtp& base, std::ostream& os) : m(base), os(&os) {}
-
-	Crtp& operator<<(const bool& b) { *os << (b ? "true" : "false"); return m; }
-	Crtp& operator<<(const std::uint8_t& b) { *os << +b; return m; }
-	Crtp& operator<<(const std::uint16_t& i) { *os << i; return m; }
-	Crtp& operator<<(const std::uint32_t& i) { *os << i; return m; }
-	Crtp& operator<<(const std::int32_t& i) { *os << i; return m; }
-	Crtp& operator<<(const std::size_t& i) { *os << i; return m; }
-	Crtp& operator<<(const char& c) { *os << '"' << c << '"'; return m; }
-	Crtp& operator<<(const float& f) { *os << f; return m; }
-	Crtp& operator<<(const char* s) { *os << '"' << s << '"'; return m; }
-	Crtp& operator<<(const std::string& s) { *os << '"' << s << '"'; return m; }
+	//! @param compact if true, the output gets neither line breaks nor indentation
+	JsonOfile(Crtp& base, std::ostream& os, bool compact = false) :
+		m(base), os(&os), compact(compact)
+	{
+		buf.reserve(flush_size + (flush_size >> 4));
+	}
+
+	~JsonOfile() { Flush(); }
+
+	//! writes all buffered output to the stream
+	void Flush()
+	{
+		os->write(buf.data(), buf.size());
+		buf.clear();
+	}
+
+	Crtp& operator<<(const bool& b) { PutRaw(b ? "true" : "false"); return Done(); }
+	Crtp& operator<<(const std::uint8_t& b) { PutUnsigned(b); return Done(); }
+	Crtp& operator<<(const std::uint16_t& i) { PutUnsigned(i); return Done(); }
+	Crtp& operator<<(const std::uint32_t& i) { PutUnsigned(i); return Done(); }
+	Crtp& operator<<(const std::int32_t& i) { PutSigned(i); return Done(); }
+	Crtp& operator<<(const std::size_t& i) { PutUnsigned(i); return Done(); }
+	Crtp& operator<<(const char& c) { PutQuoted(&c, 1); return Done(); }
+	Crtp& operator<<(const float& f) {
+		// same format as std::ostream's default
+		char tmp[32];
+		int len = std::snprintf(tmp, sizeof(tmp), "%g", f);
+		buf.insert(buf.end(), tmp, tmp + len);
+		return Done();
+	}
+	Crtp& operator<<(const char* s) { PutQuoted(s, std::strlen(s)); return Done(); }
+	Crtp& operator<<(const std::string& s) { PutQuoted(s.data(), s.length()); return Done(); }
 
 	struct ident {};
 	Crtp& operator<<(const ident&)
 	{
-		for(char i = 0; i < struct_depth; ++i) m << raw("  ");
+		if(!compact)
+		 buf.insert(buf.end(), struct_depth << 1, ' ');
 		return m;
 	}
 
@@ -165,8 +247,6 @@ public:
 	static int Est(const std::pair<T1, T2>& p) { return 4 + Est(p.first) + Est(p.second); }
 	template<class T>
 	static int Est(const T& ) { return linewidth << 1; }
-	int remain;
-	int used;
 	/* end of unused code */
 
 	template<class Cont>
@@ -175,35 +255,14 @@ public:
 		if(v.empty())
 		 return m << raw("[]");
 
-		int init_remain = linewidth -
-			(struct_depth << 1) // ident
-			- 1; // comma at the end
-		remain =
-			init_remain -
-			max_keylength - // assumed key lenght
-			4; // apostrophes for key, ': ' + comma at the end
-		int remain2 = remain - Est(v.begin());
-
-		bool nextline = true; //remain2 < 0;
-		const char* nsep = nextline ? "[\n" : "[";
-		m << /*raw('\n') << ident() <<*/ raw(nsep);
-		remain = nextline ? init_remain : remain2;
+		m << raw("[\n");
 		++struct_depth;
 
-
 		typename Cont::const_iterator it = v.begin();
-		if(nextline) m << ident();
-		else m << raw(' ');
-		m << *(it++);
+		m << ident() << *(it++);
 		for(; it != v.end(); ++it)
-		{
-			remain2 = remain - Est(*it);
-			nextline = true; /*remain2 < 0;*/
-			if(nextline) m << raw(",\n") << ident();
-			else m << raw(", ");
-			m << *it;
-			remain = nextline ? init_remain : remain2;
-		}
+		 m << raw(",\n") << ident() << *it;
+
 		--struct_depth;
 		return m << raw('\n') << ident() << raw(']');
 	}
@@ -213,7 +272,7 @@ public:
 	template<class T>
 	Crtp& operator<<(const _raw<T>& r)
 	{
-		(*os) << *r.ptr;
+		PutRaw(*r.ptr);
 		return m;
 	}
 
@@ -241,6 +300,103 @@ public:
 	}
 };
 
+//! Non-owning view on a part of a string, e.g. on a memory mapped file
+class StrView
+{
+	const char* _data;
+	std::size_t _size;
+public:
+	StrView() : _data(nullptr), _size(0) {}
+	StrView(const char* data, std::size_t size) : _data(data), _size(size) {}
+
+	const char* data() const { return _data; }
+	std::size_t size() const { return _size; }
+	bool empty() const { return !_size; }
+	std::string str() const { return std::string(_data, _size); }
+
+	bool operator==(const char* s) const {
+		return !std::strncmp(_data, s, _size) && s[_size] == 0; }
+	bool operator!=(const char* s) const { return !(*this == s); }
+};
+
+//! Read-only contents of a file, memory mapped where the system supports it
+class MappedFile
+{
+	const char* _data = nullptr;
+	std::size_t _size = 0;
+	bool mapped = false;
+	std::vector<char> copy; //!< the contents, if the file could not be mapped
+
+	MappedFile(const MappedFile& ) = delete;
+	MappedFile& operator=(const MappedFile& ) = delete;
+public:
+	//! @throw const char* if the file can not be read
+	explicit MappedFile(const char* filename);
+	~MappedFile();
+
+	StrView View() const { return StrView(_data, _size); }
+};
+
+//! Pull parser for JSON in a contiguous buffer.
+//! Strings and numbers are returned as views into the buffer,
+//! the parser itself never allocates.
+class JsonPullParser
+{
+	const char* pos;
+	const char* const end;
+
+	//! skips whitespace and returns the next character without reading it
+	char Peek();
+	void Expect(char c);
+	//! returns the characters a number consists of
+	StrView Number();
+public:
+	JsonPullParser(StrView buf) : pos(buf.data()), end(buf.data() + buf.size()) {}
+
+	//! reads the '{' starting an object
+	void BeginObject() { Expect('{'); }
+	//! reads the next key of an object and the following ':'
+	//! @return false if the end of the object was read instead
+	bool NextKey(StrView* key);
+
+	//! reads the '[' starting an array
+	void BeginArray() { Expect('['); }
+	//! prepares reading the next element of an array
+	//! @return false if the end of the array was read instead
+	bool NextElement();
+
+	//! @return the string without the quotes; escapes are not resolved
+	StrView String();
+	bool Bool();
+	float Float();
+
+	template<class T>
+	T Integer()
+	{
+		StrView v = Number();
+		const char* s = v.data();
+		const char* e = s + v.size();
+		bool neg = (*s == '-');
+		if(neg && !std::is_signed<T>::value)
+		 throw "unexpected negative number";
+		if(neg)
+		 ++s;
+		if(s == e)
+		 throw "not a number";
+		T number = 0;
+		for(; s != e; ++s)
+		{
+			if(*s < '0' || *s > '9')
+			 throw "not an integer";
+			number = number * 10 + (*s - '0');
+		}
+		return neg ? -number : number;
+	}
+
+	//! @return whether the whole buffer has been read
+	bool AtEnd();
+};
+
 //! Non-template version of JsonIfile. Can have functions inside cpp files
 class JsonIfileBase
 {
@@ -314,6 +470,8 @@ class JsonIfile : JsonIfileBase
 					if(! RdNum(exponent) )
 					 throw "expected exponent after 'e' or 'E'.";
 				case ',':
+				case ']':
+				case '}':
 				case '\n':
 					max = i;
 					break;
@@ -322,7 +480,8 @@ class JsonIfile : JsonIfileBase
 					 (number *= 10 ) += (tmp-'0');
 					else throw "not a number";
 			}
-			if(tmp != ',')
+			// separators and ends (of compact files) are read by the caller
+			if(tmp != ',' && tmp != ']' && tmp != '}')
 			 is->ignore(1);
 		}
 
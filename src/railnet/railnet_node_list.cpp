@@ -11,11 +11,45 @@
  * @file railnet_node_list.h implementation of the node_list_t class
  */
 
-#ifdef COMPILE_RAILNET
+#include <algorithm>
 #include "railnet_node_list.h"
 
+#ifdef COMPILE_RAILNET
+
+namespace {
+
+//! compares runs by their unit only
+struct CmpUnit
+{
+	template<class T>
+	bool operator()(const T& run, UnitID u) const { return run.first < u; }
+	template<class T>
+	bool operator()(UnitID u, const T& run) const { return u < run.first; }
+};
+
+}
+
 void NodeListT::Visit(UnitID u, StationID s, NodeListT::times_t nth) {
-	nodes[s].emplace(u, nth);
+	if(s >= nodes.size())
+	 nodes.resize(s + 1);
+	NodeInfoT& node = nodes[s];
+
+	// behind all runs of the same unit, to keep the visiting order
+	node.runs.emplace(std::upper_bound(node.runs.begin(), node.runs.end(), u, CmpUnit()), u, nth);
+
+	if(u / word_bits >= node.units.size())
+	 node.units.resize(u / word_bits + 1);
+	node.units[u / word_bits] |= word_t(1) << (u % word_bits);
+}
+
+const NodeListT::NodeInfoT* NodeListT::FindNode(StationID s) const
+{
+	return (s < nodes.size() && !nodes[s].runs.empty()) ? &nodes[s] : nullptr;
+}
+
+std::pair<NodeListT::RunItr, NodeListT::RunItr> NodeListT::UnitRange(const NodeInfoT& node, UnitID unit)
+{
+	return std::equal_range(node.runs.begin(), node.runs.end(), unit, CmpUnit());
 }
 
 void NodeListT::InitNodes(const comm::OrderList &ol)
@@ -85,10 +119,9 @@ bool NodeListT::FollowToNode(const std::vector<StationID>::const_iterator &itr,
 	const std::vector<StationID>::const_iterator &itr_1,
 	bool neg) const
 {
-	const auto node_itr = nodes.find(*itr);
-	if(node_itr == nodes.end())
+	const NodeInfoT* info = FindNode(*itr);
+	if(!info)
 		return false;
-	const NodeInfoT* info = &node_itr->second;
 
 	auto next = supersets.begin();
 	for(auto sitr = supersets.begin(); sitr != supersets.end(); sitr = next)
@@ -99,7 +132,7 @@ bool NodeListT::FollowToNode(const std::vector<StationID>::const_iterator &itr,
 		std::size_t& last_station_no = sitr->second.last_station_no;
 		std::size_t new_last_station_no = std::numeric_limits<std::size_t>::max();
 
-		const auto in_nodes = info->equal_range(cur_line);
+		const auto in_nodes = UnitRange(*info, cur_line);
 		std::size_t tmp = lengths.at(cur_line);
 		for(auto in_node = in_nodes.first;
 			in_node != in_nodes.second; ++in_node)
@@ -120,8 +153,8 @@ bool NodeListT::FollowToNode(const std::vector<StationID>::const_iterator &itr,
 		{
 			// was the last node visited twice before we got here?
 			// if so, this train can still be a short train
-			const auto& last_in_nodes =
-					nodes.at(*itr_1).equal_range(cur_line);
+			const auto last_in_nodes =
+					UnitRange(nodes.at(*itr_1), cur_line);
 
 			bool no_express = true;
 			if(last_station_no < new_last_station_no - 1) // some nodes between...
@@ -174,16 +207,27 @@ int NodeListT::Traverse(const comm::OrderList &ol, std::map<UnitID, NodeListT::S
 	std::multimap<UnitID, SuperInfoT> supersets;
 
 	// find first node where the train stops
-	const NodeInfoT* station_0;
-	const auto itr_0 = nodes.find(stations[0]);
-	if(itr_0 == nodes.end())
+	const NodeInfoT* station_0 = FindNode(stations[0]);
+	if(!station_0)
 		return NO_SUPERSETS;
-	else
-		station_0 = &itr_0->second;
+
+	// a superset must stop at all stations of the train, so only
+	// the units whose bits are set at every station are candidates
+	std::vector<word_t> candidates = station_0->units;
+	for(auto itr = stations.begin() + 1; itr != stations.end(); ++itr)
+	{
+		const NodeInfoT* info = FindNode(*itr);
+		if(!info)
+			return NO_SUPERSETS;
+		if(info->units.size() < candidates.size())
+			candidates.resize(info->units.size());
+		for(std::size_t i = 0; i < candidates.size(); ++i)
+			candidates[i] &= info->units[i];
+	}
 
 	// fill map for the first node
-	for(const auto& pr : *station_0)
-	if(pr.first != train)
+	for(const auto& pr : station_0->runs)
+	if(pr.first != train && HasUnit(candidates, pr.first))
 	{
 		const auto& c_oth = cargo.at(pr.first);
 		const auto& c_this = cargo.at(train);
@@ -194,13 +238,13 @@ int NodeListT::Traverse(const comm::OrderList &ol, std::map<UnitID, NodeListT::S
 
 	const auto& c_this = cargo.at(train);
 
-	for(const auto& pr : *station_0)
-	if(pr.first != train)
+	for(const auto& pr : station_0->runs)
+	if(pr.first != train && HasUnit(candidates, pr.first))
 	{
 		const auto& c_oth = cargo.at(pr.first);
 		if(ignore_cargo
 			|| std::includes(c_oth.begin(), c_oth.end(), c_this.begin(), c_this.end()))
-		if(value_of(supersets, pr.first, station_0->find(pr.first)->second, neg) != 0)
+		if(value_of(supersets, pr.first, UnitRange(*station_0, pr.first).first->second, neg) != 0)
 		 throw "Internal error: invalid value computation";
 	}
 
@@ -12,6 +12,8 @@
  */
 
 #include <map>
+#include <vector>
+#include <cstdint>
 #include "common.h"
 
 #ifdef COMPILE_RAILNET
@@ -24,15 +26,37 @@
 class NodeListT
 {
 	using times_t = unsigned short;
-	using NodeInfoT = std::multimap<UnitID, times_t>;
+	using word_t = std::uint64_t;
+	static constexpr std::size_t word_bits = 64;
 
-	//! @node: C++11 guarantees that equivalent keys remain
-	//! in the insertion order. we insert them sorted by key...
-	std::map<StationID, NodeInfoT> nodes;
+	//! all visits of one station
+	struct NodeInfoT
+	{
+		//! (unit, n'th stop) pairs, sorted by unit, equal units
+		//! in the order they were visited
+		std::vector<std::pair<UnitID, times_t>> runs;
+		//! bit u is set iff unit u stops here
+		std::vector<word_t> units;
+	};
+	using RunItr = std::vector<std::pair<UnitID, times_t>>::const_iterator;
+
+	//! indexed by station ID, stations without visits have no runs
+	std::vector<NodeInfoT> nodes;
 	std::map<UnitID, times_t> lengths;
 	std::map<UnitID, std::set<CargoLabel>> cargo;
 
 	void Visit(UnitID u, StationID s, times_t nth);
+
+	//! @return the node of station @a s, or nullptr if nobody stops there
+	const NodeInfoT* FindNode(StationID s) const;
+
+	//! @return all visits of @a unit at @a node
+	static std::pair<RunItr, RunItr> UnitRange(const NodeInfoT& node, UnitID unit);
+
+	//! @return true iff the bit of @a unit is set in @a bits
+	static bool HasUnit(const std::vector<word_t>& bits, UnitID unit) {
+		return unit / word_bits < bits.size() && ((bits[unit / word_bits] >> (unit % word_bits)) & 1);
+	}
 public:
 	void InitNodes(const comm::OrderList& ol);
 
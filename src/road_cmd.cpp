@@ -27,6 +27,7 @@
 #include "effectvehicle_func.h"
 #include "effectvehicle_base.h"
 #include "elrail_func.h"
+#include "pbs.h"
 #include "roadveh.h"
 #include "town.h"
 #include "company_base.h"
@@ -252,6 +253,8 @@ static CommandCost RemoveRoad(TileIndex tile, DoCommandFlag flags, RoadBits piec
 					MarkTileDirtyByTile(tile);
 					MarkTileDirtyByTile(other_end);
 				}
+				YapfNotifyRoadLayoutChange(tile);
+				YapfNotifyRoadLayoutChange(other_end);
 			}
 		} else {
 			assert(IsDriveThroughStopTile(tile));
@@ -265,6 +268,7 @@ static CommandCost RemoveRoad(TileIndex tile, DoCommandFlag flags, RoadBits piec
 				}
 				SetRoadTypes(tile, GetRoadTypes(tile) & ~RoadTypeToRoadTypes(rt));
 				MarkTileDirtyByTile(tile);
+				YapfNotifyRoadLayoutChange(tile);
 			}
 		}
 		return cost;
@@ -347,6 +351,7 @@ static CommandCost RemoveRoad(TileIndex tile, DoCommandFlag flags, RoadBits piec
 					SetRoadBits(tile, present, rt);
 					MarkTileDirtyByTile(tile);
 				}
+				YapfNotifyRoadLayoutChange(tile);
 			}
 
 			CommandCost cost(EXPENSES_CONSTRUCTION, CountBits(pieces) * _price[PR_CLEAR_ROAD]);
@@ -393,6 +398,7 @@ static CommandCost RemoveRoad(TileIndex tile, DoCommandFlag flags, RoadBits piec
 				}
 				MarkTileDirtyByTile(tile);
 				YapfNotifyTrackLayoutChange(tile, railtrack);
+				YapfNotifyRoadLayoutChange(tile);
 			}
 			return CommandCost(EXPENSES_CONSTRUCTION, _price[PR_CLEAR_ROAD] * 2);
 		}
@@ -561,6 +567,7 @@ CommandCost CmdBuildRoad(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 							if ((flags & DC_EXEC) && rt != ROADTYPE_TRAM && IsStraightRoad(existing)) {
 								SetDisallowedRoadDirections(tile, dis_new);
 								MarkTileDirtyByTile(tile);
+								YapfNotifyRoadLayoutChange(tile);
 							}
 							return CommandCost();
 						}
@@ -650,8 +657,10 @@ CommandCost CmdBuildRoad(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 				bool reserved = HasBit(GetRailReservationTrackBits(tile), railtrack);
 				MakeRoadCrossing(tile, company, company, GetTileOwner(tile), roaddir, GetRailType(tile), RoadTypeToRoadTypes(rt) | ROADTYPES_ROAD, p2);
 				SetCrossingReservation(tile, reserved);
+				MarkReservationsChanged();
 				UpdateLevelCrossing(tile, false);
 				MarkTileDirtyByTile(tile);
+				YapfNotifyRoadLayoutChange(tile);
 			}
 			return CommandCost(EXPENSES_CONSTRUCTION, _price[PR_BUILD_ROAD] * (rt == ROADTYPE_ROAD ? 2 : 4));
 		}
@@ -767,6 +776,7 @@ do_clear:;
 					MarkTileDirtyByTile(other_end);
 					MarkTileDirtyByTile(tile);
 				}
+				YapfNotifyRoadLayoutChange(other_end);
 				break;
 			}
 
@@ -796,6 +806,7 @@ do_clear:;
 		}
 
 		MarkTileDirtyByTile(tile);
+		YapfNotifyRoadLayoutChange(tile);
 	}
 	return cost;
 }
@@ -1042,6 +1053,7 @@ CommandCost CmdBuildRoadDepot(TileIndex tile, DoCommandFlag flags, uint32 p1, ui
 
 		MakeRoadDepot(tile, _current_company, dep->index, dir, rt);
 		MarkTileDirtyByTile(tile);
+		YapfNotifyRoadLayoutChange(tile);
 		MakeDefaultName(dep);
 	}
 	cost.AddCost(_price[PR_BUILD_DEPOT_ROAD]);
@@ -1068,6 +1080,7 @@ static CommandCost RemoveRoadDepot(TileIndex tile, DoCommandFlag flags)
 
 		delete Depot::GetByTile(tile);
 		DoClearSquare(tile);
+		YapfNotifyRoadLayoutChange(tile);
 	}
 
 	return CommandCost(EXPENSES_CONSTRUCTION, _price[PR_CLEAR_DEPOT_ROAD]);
@@ -19,6 +19,7 @@
 #include "articulated_vehicles.h"
 #include "newgrf_sound.h"
 #include "pathfinder/yapf/yapf.h"
+#include "pathfinder/pf_replay.h"
 #include "strings_func.h"
 #include "tunnelbridge_map.h"
 #include "date_func.h"
@@ -969,6 +970,7 @@ static Trackdir RoadFindPathToDest(RoadVehicle *v, TileIndex tile, DiagDirection
 
 		default: NOT_REACHED();
 	}
+	if (_pf_capture_active) PathfinderCaptureQuery(PFQ_ROADVEH, v, tile, enterdir, trackdirs, false, best_track, path_found);
 	v->HandlePathfindingResult(path_found);
 
 found_best_track:;
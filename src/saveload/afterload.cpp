@@ -772,6 +772,9 @@ bool AfterLoadGame()
 		}
 	}
 
+	/* The vehicle hash was set up for the map size before loading; size it for the loaded map. */
+	ResetVehicleHash();
+
 	/* Update all vehicles */
 	AfterLoadVehicles(true);
 
@@ -1326,6 +1329,8 @@ bool AfterLoadGame()
 	}
 
 	YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+	YapfNotifyRoadLayoutChange(INVALID_TILE);
+	YapfNotifyWaterLayoutChange(INVALID_TILE);
 
 	if (IsSavegameVersionBefore(34)) {
 		Company *c;
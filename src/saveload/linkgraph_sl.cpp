@@ -24,6 +24,7 @@ typedef LinkGraph::BaseEdge Edge;
 const SettingDesc *GetSettingDescription(uint index);
 
 static uint16 _num_nodes;
+static NodeID _next_edge; ///< Destination of the edge saved or loaded after the current one.
 
 /**
  * Get a SaveLoad array for a link graph.
@@ -126,29 +127,69 @@ static const SaveLoad _edge_desc[] = {
 	     SLE_VAR(Edge, usage,                    SLE_UINT32),
 	     SLE_VAR(Edge, last_unrestricted_update, SLE_INT32),
 	 SLE_CONDVAR(Edge, last_restricted_update,   SLE_INT32, 187, SL_MAX_VERSION),
-	     SLE_VAR(Edge, next_edge,                SLE_UINT16),
+	    SLEG_VAR(_next_edge,                     SLE_UINT16),
 	     SLE_END()
 };
 
 /**
- * Save/load a link graph.
- * @param comp Link graph to be saved or loaded.
+ * Save a link graph. The edges of each node are saved in the order of their
+ * destinations, preceded by an edge from the node to itself pointing to the
+ * first of them.
+ * @param lg Link graph to be saved.
  */
-void SaveLoad_LinkGraph(LinkGraph &lg)
+void Save_LinkGraph(LinkGraph &lg)
 {
 	uint size = lg.Size();
 	for (NodeID from = 0; from < size; ++from) {
 		Node *node = &lg.nodes[from];
 		SlObject(node, _node_desc);
+
+		LinkGraph::EdgeList &edges = lg.edges[from];
+		Edge start;
+		start.Init(from);
+		_next_edge = edges.empty() ? INVALID_NODE : edges[0].dest;
+		SlObject(&start, _edge_desc);
+		for (uint i = 0; i < edges.size(); ++i) {
+			_next_edge = i + 1 < edges.size() ? edges[i + 1].dest : INVALID_NODE;
+			SlObject(&edges[i], _edge_desc);
+		}
+	}
+}
+
+/**
+ * Load a link graph.
+ * @param lg Link graph to be loaded. It has to be initialised to the right size already.
+ */
+void Load_LinkGraph(LinkGraph &lg)
+{
+	uint size = lg.Size();
+	std::vector<Edge> row;
+	std::vector<NodeID> next;
+	for (NodeID from = 0; from < size; ++from) {
+		Node *node = &lg.nodes[from];
+		SlObject(node, _node_desc);
+		LinkGraph::EdgeList &edges = lg.edges[from];
 		if (IsSavegameVersionBefore(191)) {
 			/* We used to save the full matrix ... */
+			row.resize(size);
+			next.resize(size);
 			for (NodeID to = 0; to < size; ++to) {
-				SlObject(&lg.edges[from][to], _edge_desc);
+				row[to].Init(to);
+				SlObject(&row[to], _edge_desc);
+				next[to] = _next_edge;
+			}
+			for (NodeID to = next[from]; to != INVALID_NODE; to = next[to]) {
+				edges.insert(edges.begin() + LinkGraph::FindEdgeIndex(edges, to), row[to]);
 			}
 		} else {
 			/* ... but as that wasted a lot of space we save a sparse matrix now. */
-			for (NodeID to = from; to != INVALID_NODE; to = lg.edges[from][to].next_edge) {
-				SlObject(&lg.edges[from][to], _edge_desc);
+			Edge edge;
+			edge.Init(from);
+			SlObject(&edge, _edge_desc);
+			for (NodeID to = _next_edge; to != INVALID_NODE; to = _next_edge) {
+				edge.Init(to);
+				SlObject(&edge, _edge_desc);
+				edges.insert(edges.begin() + LinkGraph::FindEdgeIndex(edges, to), edge);
 			}
 		}
 	}
@@ -163,7 +204,7 @@ static void DoSave_LGRJ(LinkGraphJob *lgj)
 	SlObject(lgj, GetLinkGraphJobDesc());
 	_num_nodes = lgj->Size();
 	SlObject(const_cast<LinkGraph *>(&lgj->Graph()), GetLinkGraphDesc());
-	SaveLoad_LinkGraph(const_cast<LinkGraph &>(lgj->Graph()));
+	Save_LinkGraph(const_cast<LinkGraph &>(lgj->Graph()));
 }
 
 /**
@@ -174,7 +215,7 @@ static void DoSave_LGRP(LinkGraph *lg)
 {
 	_num_nodes = lg->Size();
 	SlObject(lg, GetLinkGraphDesc());
-	SaveLoad_LinkGraph(*lg);
+	Save_LinkGraph(*lg);
 }
 
 /**
@@ -191,7 +232,7 @@ static void Load_LGRP()
 		LinkGraph *lg = new (index) LinkGraph();
 		SlObject(lg, GetLinkGraphDesc());
 		lg->Init(_num_nodes);
-		SaveLoad_LinkGraph(*lg);
+		Load_LinkGraph(*lg);
 	}
 }
 
@@ -211,7 +252,7 @@ static void Load_LGRJ()
 		LinkGraph &lg = const_cast<LinkGraph &>(lgj->Graph());
 		SlObject(&lg, GetLinkGraphDesc());
 		lg.Init(_num_nodes);
-		SaveLoad_LinkGraph(lg);
+		Load_LinkGraph(lg);
 	}
 }
 
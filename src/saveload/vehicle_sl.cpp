@@ -725,6 +725,14 @@ const SaveLoad *GetVehicleDescription(VehicleType vt)
 		 SLE_CONDVAR(Train, gv_flags,            SLE_UINT16,                 139, SL_MAX_VERSION),
 		SLE_CONDNULL(11, 2, 143), // old reserved space
 
+		 SLE_CONDARR(Train, path_cache.tile,     SLE_UINT32, TRAIN_PATH_CACHE_SIZE, 196, SL_MAX_VERSION),
+		 SLE_CONDARR(Train, path_cache.td,       SLE_UINT8,  TRAIN_PATH_CACHE_SIZE, 196, SL_MAX_VERSION),
+		 SLE_CONDVAR(Train, path_cache.next,     SLE_UINT8,                  196, SL_MAX_VERSION),
+		 SLE_CONDVAR(Train, path_cache.count,    SLE_UINT8,                  196, SL_MAX_VERSION),
+		 SLE_CONDVAR(Train, path_cache.order_type, SLE_UINT8,                196, SL_MAX_VERSION),
+		 SLE_CONDVAR(Train, path_cache.order_dest, SLE_UINT16,               196, SL_MAX_VERSION),
+		 SLE_CONDVAR(Train, path_cache.expire,   SLE_UINT16,                 196, SL_MAX_VERSION),
+
 		     SLE_END()
 	};
 
@@ -67,6 +67,7 @@
 
 #include "void_map.h"
 #include "station_base.h"
+#include "linkgraph/linkgraphschedule.h"
 
 #include "table/strings.h"
 #include "table/settings.h"
@@ -1311,6 +1312,14 @@ static bool MaxVehiclesChanged(int32 p1)
 	return true;
 }
 
+static bool LinkGraphThreadsChanged(int32 p1)
+{
+	/* Running link graph jobs are queued in the pool. */
+	LinkGraphSchedule::instance.WaitForAll();
+	LinkGraphSchedule::UninitializeWorkers();
+	return true;
+}
+
 
 #ifdef ENABLE_NETWORK
 
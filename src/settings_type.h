@@ -103,6 +103,7 @@ struct GUISettings {
 	bool   disable_unsuitable_building;      ///< disable infrastructure building when no suitable vehicles are available
 	byte   autosave;                         ///< how often should we do autosaves?
 	bool   threaded_saves;                   ///< should we do threaded saves?
+	uint8  linkgraph_threads;                ///< number of threads for running link graph jobs (0 = one per core)
 	bool   keep_all_autosave;                ///< name the autosave in a different way
 	bool   autosave_on_exit;                 ///< save an autosave when you quit the game, but do not ask "Do you really want to quit?"
 	uint8  date_format_in_default_names;     ///< should the default savegame/screenshot name use long dates (31th Dec 2008), short dates (31-12-2008) or ISO dates (2008-12-31)
@@ -383,6 +384,9 @@ struct YAPFSettings {
 	uint32 road_stop_penalty;                ///< penalty for going through a drive-through road stop
 	uint32 road_stop_occupied_penalty;       ///< penalty multiplied by the fill percentage of a drive-through road stop
 	uint32 road_stop_bay_occupied_penalty;   ///< penalty multiplied by the fill percentage of a road bay
+	bool   road_use_regions;                 ///< guide road vehicles over long distances by the connectivity of map regions
+	bool   ship_use_regions;                 ///< guide ships over long distances by the connectivity of map regions
+	bool   cache_depot_distances;            ///< find the nearest depot for servicing in tables of the distances to all depots
 	bool   rail_firstred_twoway_eol;         ///< treat first red two-way signal as dead end
 	uint32 rail_firstred_penalty;            ///< penalty for first red signal
 	uint32 rail_firstred_exit_penalty;       ///< penalty for first red exit signal
@@ -402,6 +406,8 @@ struct YAPFSettings {
 	uint32 rail_pbs_station_penalty;         ///< penalty for crossing a reserved station tile
 	uint32 rail_pbs_signal_back_penalty;     ///< penalty for passing a pbs signal from the backside
 	uint32 rail_doubleslip_penalty;          ///< penalty for passing a double slip switch
+	uint8  rail_path_cache_junctions;        ///< number of junctions after the next one a train keeps the choice of a path search for (0 = disabled)
+	uint16 rail_path_cache_ticks;            ///< number of ticks the remembered choices of a path search stay valid
 
 	uint32 rail_longer_platform_penalty;           ///< penalty for longer  station platform than train
 	uint32 rail_longer_platform_per_tile_penalty;  ///< penalty for longer  station platform than train (per tile)
@@ -501,6 +507,9 @@ struct LinkGraphSettings {
 	uint8 demand_size;                          ///< influence of supply ("station size") on the demand function
 	uint8 demand_distance;                      ///< influence of distance between stations on the demand function
 	uint8 short_path_saturation;                ///< percentage up to which short paths are saturated before saturating most capacious paths
+	uint8 mcf_batch_size;                       ///< number of sources whose paths are searched at once, in parallel, by the multi-commodity flow solver
+	uint8 jobs_per_interval;                    ///< number of link graph jobs started and joined every recalc_interval
+	bool postpone_overdue_jobs;                 ///< postpone joining link graph jobs that are not done on the server instead of waiting for them
 
 	inline DistributionType GetDistributionType(CargoID cargo) const {
 		if (IsCargoInClass(cargo, CC_PASSENGERS)) return this->distribution_pax;
@@ -29,6 +29,7 @@
 #include "sound_func.h"
 #include "ai/ai.hpp"
 #include "pathfinder/opf/opf_ship.h"
+#include "pathfinder/pf_replay.h"
 #include "engine_base.h"
 #include "company_base.h"
 #include "tunnelbridge_map.h"
@@ -444,6 +445,7 @@ static Track ChooseShipTrack(Ship *v, TileIndex tile, DiagDirection enterdir, Tr
 		default: NOT_REACHED();
 	}
 
+	if (_pf_capture_active) PathfinderCaptureQuery(PFQ_SHIP, v, tile, enterdir, tracks, false, track, path_found);
 	v->HandlePathfindingResult(path_found);
 	return track;
 }
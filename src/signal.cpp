@@ -17,17 +17,20 @@
 #include "viewport_func.h"
 #include "train.h"
 #include "company_base.h"
+#include "core/smallvec_type.hpp"
+
+#include <map>
 
 #include "safeguards.h"
 
 
-/** these are the maximums used for updating signal blocks */
+/** these are the steps by which the sets used for updating signal blocks grow */
 static const uint SIG_TBU_SIZE    =  64; ///< number of signals entering to block
 static const uint SIG_TBD_SIZE    = 256; ///< number of intersections - open nodes in current block
 static const uint SIG_GLOB_SIZE   = 128; ///< number of open blocks (block can be opened more times until detected)
 static const uint SIG_GLOB_UPDATE =  64; ///< how many items need to be in _globset to force update
 
-assert_compile(SIG_GLOB_UPDATE <= SIG_GLOB_SIZE);
+static const uint SIG_CACHE_ITEMS = 1 << 20; ///< number of remembered tiles and signals after which all remembered segments are forgotten
 
 /** incidating trackbits with given enterdir */
 static const TrackBits _enterdir_to_trackbits[DIAGDIR_END] = {
@@ -46,41 +49,27 @@ static const TrackdirBits _enterdir_to_trackdirbits[DIAGDIR_END] = {
 };
 
 /**
- * Set containing 'items' items of 'tile and Tdir'
+ * Set containing items of 'tile and Tdir'
  * No tree structure is used because it would cause
  * slowdowns in most usual cases
+ * The set grows by 'items' items when it is full.
  */
 template <typename Tdir, uint items>
 struct SmallSet {
 private:
-	uint n;           // actual number of units
-	bool overflowed;  // did we try to overflow the set?
-	const char *name; // name, used for debugging purposes...
-
 	/** Element of set */
 	struct SSdata {
 		TileIndex tile;
 		Tdir dir;
-	} data[items];
+	};
 
-public:
-	/** Constructor - just set default values and 'name' */
-	SmallSet(const char *name) : n(0), overflowed(false), name(name) { }
+	SmallVector<SSdata, items> data; // the units
 
+public:
 	/** Reset variables to default values */
 	void Reset()
 	{
-		this->n = 0;
-		this->overflowed = false;
-	}
-
-	/**
-	 * Returns value of 'overflowed'
-	 * @return did we try to overflow the set?
-	 */
-	bool Overflowed()
-	{
-		return this->overflowed;
+		this->data.Clear();
 	}
 
 	/**
@@ -89,16 +78,7 @@ public:
 	 */
 	bool IsEmpty()
 	{
-		return this->n == 0;
-	}
-
-	/**
-	 * Checks for full set
-	 * @return is the set full?
-	 */
-	bool IsFull()
-	{
-		return this->n == lengthof(data);
+		return this->data.Length() == 0;
 	}
 
 	/**
@@ -107,7 +87,7 @@ public:
 	 */
 	uint Items()
 	{
-		return this->n;
+		return this->data.Length();
 	}
 
 
@@ -119,9 +99,9 @@ public:
 	 */
 	bool Remove(TileIndex tile, Tdir dir)
 	{
-		for (uint i = 0; i < this->n; i++) {
+		for (uint i = 0; i < this->data.Length(); i++) {
 			if (this->data[i].tile == tile && this->data[i].dir == dir) {
-				this->data[i] = this->data[--this->n];
+				this->data.Erase(&this->data[i]);
 				return true;
 			}
 		}
@@ -137,7 +117,7 @@ public:
 	 */
 	bool IsIn(TileIndex tile, Tdir dir)
 	{
-		for (uint i = 0; i < this->n; i++) {
+		for (uint i = 0; i < this->data.Length(); i++) {
 			if (this->data[i].tile == tile && this->data[i].dir == dir) return true;
 		}
 
@@ -145,25 +125,15 @@ public:
 	}
 
 	/**
-	 * Adds tile & dir into the set, checks for full set
-	 * Sets the 'overflowed' flag if the set was full
+	 * Adds tile & dir into the set
 	 * @param tile tile
 	 * @param dir and dir to add
-	 * @return true iff the item could be added (set wasn't full)
 	 */
-	bool Add(TileIndex tile, Tdir dir)
+	void Add(TileIndex tile, Tdir dir)
 	{
-		if (this->IsFull()) {
-			overflowed = true;
-			DEBUG(misc, 0, "SignalSegment too complex. Set %s is full (maximum %d)", name, items);
-			return false; // set is full
-		}
-
-		this->data[this->n].tile = tile;
-		this->data[this->n].dir = dir;
-		this->n++;
-
-		return true;
+		SSdata *item = this->data.Append();
+		item->tile = tile;
+		item->dir = dir;
 	}
 
 	/**
@@ -174,19 +144,20 @@ public:
 	 */
 	bool Get(TileIndex *tile, Tdir *dir)
 	{
-		if (this->n == 0) return false;
+		if (this->data.Length() == 0) return false;
 
-		this->n--;
-		*tile = this->data[this->n].tile;
-		*dir = this->data[this->n].dir;
+		const SSdata &item = this->data[this->data.Length() - 1];
+		*tile = item.tile;
+		*dir = item.dir;
+		this->data.Resize(this->data.Length() - 1);
 
 		return true;
 	}
 };
 
-static SmallSet<Trackdir, SIG_TBU_SIZE> _tbuset("_tbuset");         ///< set of signals that will be updated
-static SmallSet<DiagDirection, SIG_TBD_SIZE> _tbdset("_tbdset");    ///< set of open nodes in current signal block
-static SmallSet<DiagDirection, SIG_GLOB_SIZE> _globset("_globset"); ///< set of places to be updated in following runs
+static SmallSet<Trackdir, SIG_TBU_SIZE> _tbuset;         ///< set of signals that will be updated
+static SmallSet<DiagDirection, SIG_TBD_SIZE> _tbdset;    ///< set of open nodes in current signal block
+static SmallSet<DiagDirection, SIG_GLOB_SIZE> _globset; ///< set of places to be updated in following runs
 
 
 /** Check whether there is a train on rail, not in a depot */
@@ -235,13 +206,10 @@ static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t
  * @param d1 direction (tile side) we are entering
  * @param t2 tile we are leaving
  * @param d2 direction (tile side) we are leaving
- * @return false iff the Todo buffer would be overrun
  */
-static inline bool MaybeAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
+static inline void MaybeAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
 {
-	if (!CheckAddToTodoSet(t1, d1, t2, d2)) return true;
-
-	return _tbdset.Add(t1, d1);
+	if (CheckAddToTodoSet(t1, d1, t2, d2)) _tbdset.Add(t1, d1);
 }
 
 
@@ -253,13 +221,130 @@ enum SigFlags {
 	SF_EXIT2  = 1 << 2, ///< two or more exits found
 	SF_GREEN  = 1 << 3, ///< green exitsignal found
 	SF_GREEN2 = 1 << 4, ///< two or more green exits found
-	SF_FULL   = 1 << 5, ///< some of buffers was full, do not continue
-	SF_PBS    = 1 << 6, ///< pbs signal found
+	SF_PBS    = 1 << 5, ///< pbs signal found
 };
 
 DECLARE_ENUM_AS_BIT_SET(SigFlags)
 
 
+/** A tile or signal found while searching a signal block. */
+struct SignalSegmentItem {
+	TileIndex tile; ///< The tile.
+	byte bits;      ///< Track bits to check for trains, #TRACK_BIT_NONE for the whole tile; or the trackdir of the signal.
+};
+
+/**
+ * What searching a signal block from one starting point found, as far as
+ * it only depends on the track layout. While the layout stays the same, the
+ * block does not have to be searched again; only trains and signal states
+ * have to be checked.
+ */
+struct SignalSegment {
+	SigFlags flags;                              ///< Flags that do not depend on trains or signal states.
+	SmallVector<SignalSegmentItem, 16> tiles;   ///< Tiles to check for trains.
+	SmallVector<SignalSegmentItem, 4> updates;  ///< Signals to update, in the order they were found.
+	SmallVector<SignalSegmentItem, 4> exits;    ///< Presignal exits in the direction of the search.
+};
+
+typedef std::map<uint64, SignalSegment *> SignalSegmentMap;
+static SignalSegmentMap _signal_segments; ///< Remembered searches, by start and owner.
+static uint _signal_segment_items;        ///< Number of tiles and signals in #_signal_segments.
+static SignalSegment *_segment_record;    ///< Segment the current search is recorded into, if any.
+
+/**
+ * Forget all remembered signal blocks, because the track layout,
+ * signals or owners of tiles changed.
+ */
+void InvalidateSignalSegments()
+{
+	for (SignalSegmentMap::iterator it = _signal_segments.begin(); it != _signal_segments.end(); ++it) delete it->second;
+	_signal_segments.clear();
+	_signal_segment_items = 0;
+}
+
+/**
+ * Check for a train on a tile of the signal block.
+ * @param flags Flags of the block, updated when a train is found.
+ * @param tile The tile.
+ * @param tracks Tracks to check, or #TRACK_BIT_NONE to check the whole tile.
+ */
+static void CheckSegmentTile(SigFlags *flags, TileIndex tile, TrackBits tracks)
+{
+	if (_segment_record != NULL) {
+		SignalSegmentItem *item = _segment_record->tiles.Append();
+		item->tile = tile;
+		item->bits = tracks;
+	}
+
+	/* If no train detected yet, and there is not no train -> there is a train -> set the flag */
+	if (*flags & SF_TRAIN) return;
+	if (tracks == TRACK_BIT_NONE ? HasVehicleOnPos(tile, NULL, &TrainOnTileEnum) : EnsureNoTrainOnTrackBits(tile, tracks).Failed()) *flags |= SF_TRAIN;
+}
+
+/**
+ * Add a signal around the signal block to the 'to-be-updated' set.
+ * @param tile The tile of the signal.
+ * @param trackdir The trackdir of the signal.
+ */
+static void AddSegmentSignal(TileIndex tile, Trackdir trackdir)
+{
+	if (_segment_record != NULL) {
+		SignalSegmentItem *item = _segment_record->updates.Append();
+		item->tile = tile;
+		item->bits = trackdir;
+	}
+
+	_tbuset.Add(tile, trackdir);
+}
+
+/**
+ * Count a presignal exit of the signal block.
+ * @param flags Flags of the block, updated for the exit.
+ * @param tile The tile of the signal.
+ * @param trackdir The trackdir of the signal.
+ */
+static void CheckSegmentExit(SigFlags *flags, TileIndex tile, Trackdir trackdir)
+{
+	if (_segment_record != NULL) {
+		SignalSegmentItem *item = _segment_record->exits.Append();
+		item->tile = tile;
+		item->bits = trackdir;
+	}
+
+	/* if we haven't found 2 green exits yet, do special check */
+	if (*flags & SF_GREEN2) return;
+	if (*flags & SF_EXIT) *flags |= SF_EXIT2; // found two (or more) exits
+	*flags |= SF_EXIT; // found at least one exit - allow for compiler optimizations
+	if (GetSignalStateByTrackdir(tile, trackdir) == SIGNAL_STATE_GREEN) { // found green presignal exit
+		if (*flags & SF_GREEN) *flags |= SF_GREEN2;
+		*flags |= SF_GREEN;
+	}
+}
+
+/**
+ * Check a remembered signal block for trains and signal states,
+ * and fill the 'to-be-updated' set with its signals.
+ * @param segment The remembered block.
+ * @return SigFlags
+ */
+static SigFlags ReplaySegment(const SignalSegment *segment)
+{
+	SigFlags flags = segment->flags;
+
+	for (const SignalSegmentItem *item = segment->tiles.Begin(); item != segment->tiles.End() && !(flags & SF_TRAIN); item++) {
+		CheckSegmentTile(&flags, item->tile, (TrackBits)item->bits);
+	}
+	for (const SignalSegmentItem *item = segment->updates.Begin(); item != segment->updates.End(); item++) {
+		_tbuset.Add(item->tile, (Trackdir)item->bits);
+	}
+	for (const SignalSegmentItem *item = segment->exits.Begin(); item != segment->exits.End() && !(flags & SF_GREEN2); item++) {
+		CheckSegmentExit(&flags, item->tile, (Trackdir)item->bits);
+	}
+
+	return flags;
+}
+
+
 /**
  * Search signal block
  *
@@ -283,13 +368,13 @@ static SigFlags ExploreSegment(Owner owner)
 
 				if (IsRailDepot(tile)) {
 					if (enterdir == INVALID_DIAGDIR) { // from 'inside' - train just entered or left the depot
-						if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+						CheckSegmentTile(&flags, tile, TRACK_BIT_NONE);
 						exitdir = GetRailDepotDirection(tile);
 						tile += TileOffsByDiagDir(exitdir);
 						enterdir = ReverseDiagDir(exitdir);
 						break;
 					} else if (enterdir == GetRailDepotDirection(tile)) { // entered a depot
-						if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+						CheckSegmentTile(&flags, tile, TRACK_BIT_NONE);
 						continue;
 					} else {
 						continue;
@@ -302,11 +387,10 @@ static SigFlags ExploreSegment(Owner owner)
 
 				if (tracks == TRACK_BIT_HORZ || tracks == TRACK_BIT_VERT) { // there is exactly one incidating track, no need to check
 					tracks = tracks_masked;
-					/* If no train detected yet, and there is not no train -> there is a train -> set the flag */
-					if (!(flags & SF_TRAIN) && EnsureNoTrainOnTrackBits(tile, tracks).Failed()) flags |= SF_TRAIN;
+					CheckSegmentTile(&flags, tile, tracks);
 				} else {
 					if (tracks_masked == TRACK_BIT_NONE) continue; // no incidating track
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					CheckSegmentTile(&flags, tile, TRACK_BIT_NONE);
 				}
 
 				if (HasSignals(tile)) { // there is exactly one track - not zero, because there is exit from this tile
@@ -321,21 +405,14 @@ static SigFlags ExploreSegment(Owner owner)
 						if (HasSignalOnTrackdir(tile, reversedir)) {
 							if (IsPbsSignal(sig)) {
 								flags |= SF_PBS;
-							} else if (!_tbuset.Add(tile, reversedir)) {
-								return flags | SF_FULL;
+							} else {
+								AddSegmentSignal(tile, reversedir);
 							}
 						}
 						if (HasSignalOnTrackdir(tile, trackdir) && !IsOnewaySignal(tile, track)) flags |= SF_PBS;
 
-						/* if it is a presignal EXIT in OUR direction and we haven't found 2 green exits yes, do special check */
-						if (!(flags & SF_GREEN2) && IsPresignalExit(tile, track) && HasSignalOnTrackdir(tile, trackdir)) { // found presignal exit
-							if (flags & SF_EXIT) flags |= SF_EXIT2; // found two (or more) exits
-							flags |= SF_EXIT; // found at least one exit - allow for compiler optimizations
-							if (GetSignalStateByTrackdir(tile, trackdir) == SIGNAL_STATE_GREEN) { // found green presignal exit
-								if (flags & SF_GREEN) flags |= SF_GREEN2;
-								flags |= SF_GREEN;
-							}
-						}
+						/* if it is a presignal EXIT in OUR direction, count it */
+						if (IsPresignalExit(tile, track) && HasSignalOnTrackdir(tile, trackdir)) CheckSegmentExit(&flags, tile, trackdir);
 
 						continue;
 					}
@@ -345,7 +422,7 @@ static SigFlags ExploreSegment(Owner owner)
 					if (dir != enterdir && (tracks & _enterdir_to_trackbits[dir])) { // any track incidating?
 						TileIndex newtile = tile + TileOffsByDiagDir(dir);  // new tile to check
 						DiagDirection newdir = ReverseDiagDir(dir); // direction we are entering from
-						if (!MaybeAddToTodoSet(newtile, newdir, tile, dir)) return flags | SF_FULL;
+						MaybeAddToTodoSet(newtile, newdir, tile, dir);
 					}
 				}
 
@@ -358,7 +435,7 @@ static SigFlags ExploreSegment(Owner owner)
 				if (DiagDirToAxis(enterdir) != GetRailStationAxis(tile)) continue; // different axis
 				if (IsStationTileBlocked(tile)) continue; // 'eye-candy' station tile
 
-				if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+				CheckSegmentTile(&flags, tile, TRACK_BIT_NONE);
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -367,7 +444,7 @@ static SigFlags ExploreSegment(Owner owner)
 				if (GetTileOwner(tile) != owner) continue;
 				if (DiagDirToAxis(enterdir) == GetCrossingRoadAxis(tile)) continue; // different axis
 
-				if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+				CheckSegmentTile(&flags, tile, TRACK_BIT_NONE);
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -377,13 +454,13 @@ static SigFlags ExploreSegment(Owner owner)
 				DiagDirection dir = GetTunnelBridgeDirection(tile);
 
 				if (enterdir == INVALID_DIAGDIR) { // incoming from the wormhole
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					CheckSegmentTile(&flags, tile, TRACK_BIT_NONE);
 					enterdir = dir;
 					exitdir = ReverseDiagDir(dir);
 					tile += TileOffsByDiagDir(exitdir); // just skip to next tile
 				} else { // NOT incoming from the wormhole!
 					if (ReverseDiagDir(enterdir) != dir) continue;
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					CheckSegmentTile(&flags, tile, TRACK_BIT_NONE);
 					tile = GetOtherTunnelBridgeEnd(tile); // just skip to exit tile
 					enterdir = INVALID_DIAGDIR;
 					exitdir = INVALID_DIAGDIR;
@@ -395,7 +472,7 @@ static SigFlags ExploreSegment(Owner owner)
 				continue; // continue the while() loop
 		}
 
-		if (!MaybeAddToTodoSet(tile, enterdir, oldtile, exitdir)) return flags | SF_FULL;
+		MaybeAddToTodoSet(tile, enterdir, oldtile, exitdir);
 	}
 
 	return flags;
@@ -443,7 +520,7 @@ static void UpdateSignalsAroundSegment(SigFlags flags)
 			if (IsPresignalExit(tile, TrackdirToTrack(trackdir))) {
 				/* for pre-signal exits, add block to the global set */
 				DiagDirection exitdir = TrackdirToExitdir(ReverseTrackdir(trackdir));
-				_globset.Add(tile, exitdir); // do not check for full global set, first update all signals
+				_globset.Add(tile, exitdir); // do not force an update of the global set, first update all signals
 			}
 			SetSignalStateByTrackdir(tile, trackdir, newstate);
 			MarkTileDirtyByTile(tile);
@@ -453,12 +530,39 @@ static void UpdateSignalsAroundSegment(SigFlags flags)
 }
 
 
-/** Reset all sets after one set overflowed */
-static inline void ResetSets()
+/**
+ * Search the signal block that is in _tbdset, or check the remembered
+ * block when it was searched from the same start before.
+ *
+ * @param tile tile from _globset the search starts at
+ * @param dir direction from _globset the search starts at
+ * @param owner owner whose signals we are updating
+ * @return SigFlags
+ */
+static SigFlags CheckSegment(TileIndex tile, DiagDirection dir, Owner owner)
 {
-	_tbuset.Reset();
-	_tbdset.Reset();
-	_globset.Reset();
+	/* Searching removes all visited places from _globset, which the remembered block can't do. */
+	if (!_globset.IsEmpty()) return ExploreSegment(owner);
+
+	uint64 key = (uint64)tile | (uint64)dir << 32 | (uint64)owner << 40;
+	SignalSegmentMap::const_iterator it = _signal_segments.find(key);
+	if (it != _signal_segments.end()) {
+		_tbdset.Reset();
+		return ReplaySegment(it->second);
+	}
+
+	if (_signal_segment_items >= SIG_CACHE_ITEMS) InvalidateSignalSegments();
+
+	SignalSegment *segment = new SignalSegment();
+	_segment_record = segment;
+	SigFlags flags = ExploreSegment(owner);
+	_segment_record = NULL;
+
+	segment->flags = flags & SF_PBS;
+	_signal_segment_items += segment->tiles.Length() + segment->updates.Length() + segment->exits.Length();
+	_signal_segments[key] = segment;
+
+	return flags;
 }
 
 
@@ -483,6 +587,9 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 		assert(_tbuset.IsEmpty());
 		assert(_tbdset.IsEmpty());
 
+		TileIndex start_tile = tile;
+		DiagDirection start_dir = dir;
+
 		/* After updating signal, data stored are always MP_RAILWAY with signals.
 		 * Other situations happen when data are from outside functions -
 		 * modification of railbits (including both rail building and removal),
@@ -526,27 +633,20 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 				continue; // continue the while() loop
 		}
 
-		assert(!_tbdset.Overflowed()); // it really shouldn't overflow by these one or two items
 		assert(!_tbdset.IsEmpty()); // it wouldn't hurt anyone, but shouldn't happen too
 
-		SigFlags flags = ExploreSegment(owner);
+		SigFlags flags = CheckSegment(start_tile, start_dir, owner);
 
 		if (first) {
 			first = false;
 			/* SIGSEG_FREE is set by default */
 			if (flags & SF_PBS) {
 				state = SIGSEG_PBS;
-			} else if ((flags & SF_TRAIN) || ((flags & SF_EXIT) && !(flags & SF_GREEN)) || (flags & SF_FULL)) {
+			} else if ((flags & SF_TRAIN) || ((flags & SF_EXIT) && !(flags & SF_GREEN))) {
 				state = SIGSEG_FULL;
 			}
 		}
 
-		/* do not do anything when some buffer was full */
-		if (flags & SF_FULL) {
-			ResetSets(); // free all sets
-			break;
-		}
-
 		UpdateSignalsAroundSegment(flags);
 	}
 
@@ -591,6 +691,9 @@ void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner)
 
 	_last_owner = owner;
 
+	/* The track or its signals changed, or the caller is about to update them anyway. */
+	InvalidateSignalSegments();
+
 	_globset.Add(tile, _search_dir_1[track]);
 	_globset.Add(tile, _search_dir_2[track]);
 
@@ -616,6 +719,9 @@ void AddSideToSignalBuffer(TileIndex tile, DiagDirection side, Owner owner)
 
 	_last_owner = owner;
 
+	/* The track or its signals changed, or the caller is about to update them anyway. */
+	InvalidateSignalSegments();
+
 	_globset.Add(tile, side);
 
 	if (_globset.Items() >= SIG_GLOB_UPDATE) {
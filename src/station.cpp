@@ -97,9 +97,11 @@ Station::~Station()
 		if (lg == NULL) continue;
 
 		for (NodeID node = 0; node < lg->Size(); ++node) {
-			Station *st = Station::Get((*lg)[node].Station());
+			/* Not every node has an edge to this station, so look them up read-only. */
+			LinkGraph::ConstNode from = static_cast<const LinkGraph &>(*lg)[node];
+			Station *st = Station::Get(from.Station());
 			st->goods[c].flows.erase(this->index);
-			if ((*lg)[node][this->goods[c].node].LastUpdate() != INVALID_DATE) {
+			if (from[this->goods[c].node].LastUpdate() != INVALID_DATE) {
 				st->goods[c].flows.DeleteFlows(this->index);
 				RerouteCargo(st, c, this->index, st->index);
 			}
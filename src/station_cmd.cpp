@@ -1862,6 +1862,7 @@ CommandCost CmdBuildRoadStop(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 			DirtyCompanyInfrastructureWindows(st->owner);
 
 			MarkTileDirtyByTile(cur_tile);
+			YapfNotifyRoadLayoutChange(cur_tile);
 		}
 	}
 
@@ -1965,6 +1966,7 @@ static CommandCost RemoveRoadStop(TileIndex tile, DoCommandFlag flags)
 		} else {
 			DoClearSquare(tile);
 		}
+		YapfNotifyRoadLayoutChange(tile);
 
 		SetWindowWidgetDirty(WC_STATION_VIEW, st->index, WID_SV_ROADVEHS);
 		delete cur_stop;
@@ -2058,6 +2060,7 @@ CommandCost CmdRemoveRoadStop(TileIndex tile, DoCommandFlag flags, uint32 p1, ui
 		if ((flags & DC_EXEC) && rts != ROADTYPES_NONE) {
 			MakeRoadNormal(cur_tile, road_bits, rts, ClosestTownFromTile(cur_tile, UINT_MAX)->index,
 					road_owner[ROADTYPE_ROAD], road_owner[ROADTYPE_TRAM]);
+			YapfNotifyRoadLayoutChange(cur_tile);
 
 			/* Update company infrastructure counts. */
 			RoadType rt;
@@ -2535,6 +2538,8 @@ CommandCost CmdBuildDock(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 		DirtyCompanyInfrastructureWindows(st->owner);
 
 		MakeDock(tile, st->owner, st->index, direction, wc);
+		YapfNotifyWaterLayoutChange(tile);
+		YapfNotifyWaterLayoutChange(tile + TileOffsByDiagDir(direction));
 
 		st->UpdateVirtCoord();
 		UpdateStationAcceptance(st, false);
@@ -2571,6 +2576,7 @@ static CommandCost RemoveDock(TileIndex tile, DoCommandFlag flags)
 	if (flags & DC_EXEC) {
 		DoClearSquare(tile1);
 		MarkTileDirtyByTile(tile1);
+		YapfNotifyWaterLayoutChange(tile1);
 		MakeWaterKeepingClass(tile2, st->owner);
 
 		st->rect.AfterRemoveTile(st, tile1);
@@ -3449,11 +3455,14 @@ void DeleteStaleLinks(Station *from)
 		LinkGraph *lg = LinkGraph::GetIfValid(ge.link_graph);
 		if (lg == NULL) continue;
 		Node node = (*lg)[ge.node];
-		for (EdgeIterator it(node.Begin()); it != node.End();) {
-			Edge edge = it->second;
-			Station *to = Station::Get((*lg)[it->first].Station());
-			assert(to->goods[c].node == it->first);
-			++it; // Do that before removing the edge. Anything else may crash.
+		/* Refreshing and removing links changes the edges of the node, which
+		 * invalidates edge iterators. Remember the destinations beforehand. */
+		SmallVector<NodeID, 16> dests;
+		for (EdgeIterator it(node.Begin()); it != node.End(); ++it) *dests.Append() = it->first;
+		for (const NodeID *dest = dests.Begin(); dest != dests.End(); ++dest) {
+			Edge edge = node[*dest];
+			Station *to = Station::Get((*lg)[*dest].Station());
+			assert(to->goods[c].node == *dest);
 			assert(_date >= edge.LastUpdate());
 			uint timeout = LinkGraph::MIN_TIMEOUT_DISTANCE + (DistanceManhattan(from->xy, to->xy) >> 3);
 			if ((uint)(_date - edge.LastUpdate()) > timeout) {
@@ -3483,7 +3492,8 @@ void DeleteStaleLinks(Station *from)
 						 *   same list already and if the consist can actually carry the cargo we're looking
 						 *   for. With conditional and refit orders this is not quite trivial, though. */
 						LinkRefresher::Run(v, false); // Don't allow merging. Otherwise lg might get deleted.
-						if (edge.LastUpdate() == _date) updated = true;
+						/* Refreshing may add edges, which invalidates the edge wrapper. Look it up again. */
+						if (node[to->goods[c].node].LastUpdate() == _date) updated = true;
 					}
 					if (updated) break;
 				}
@@ -0,0 +1,189 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_pool.cpp Implementation of the pool of worker threads. */
+
+#include "../stdafx.h"
+#include "worker_pool.h"
+
+#include "../safeguards.h"
+
+/** Create an empty batch. */
+WorkerPoolBatch::WorkerPoolBatch() : mutex(ThreadMutex::New()), remaining(0)
+{
+}
+
+/** Free the batch's resources; all its tasks have to be done. */
+WorkerPoolBatch::~WorkerPoolBatch()
+{
+	assert(this->remaining == 0);
+	delete this->mutex;
+}
+
+/** Mark one of the tasks of the batch as done and wake up whoever waits for the batch. */
+void WorkerPoolBatch::Finish()
+{
+	ThreadMutexLocker lock(this->mutex);
+	assert(this->remaining > 0);
+	if (--this->remaining == 0) this->mutex->SendSignal();
+}
+
+/**
+ * Check without blocking whether all tasks of the batch are done.
+ * The batch still has to be given to WorkerPool::Wait.
+ * @return True when Wait would return right away.
+ */
+bool WorkerPoolBatch::IsDone()
+{
+	ThreadMutexLocker lock(this->mutex);
+	return this->remaining == 0;
+}
+
+/**
+ * Create a pool and start its threads.
+ * @param workers Number of threads to start. Less threads are started when the system cannot create them.
+ */
+WorkerPool::WorkerPool(uint workers) : mutex(ThreadMutex::New()), exit(false)
+{
+	for (uint i = 0; i < workers; i++) {
+		ThreadObject *thread;
+		if (!ThreadObject::New(&WorkerPool::WorkerThread, this, &thread)) break;
+		*this->threads.Append() = thread;
+	}
+}
+
+/** Stop all threads of the pool; the queue has to be empty. */
+WorkerPool::~WorkerPool()
+{
+	this->mutex->BeginCritical();
+	assert(this->queue.empty());
+	this->exit = true;
+	for (uint i = 0; i < this->threads.Length(); i++) this->mutex->SendSignal();
+	this->mutex->EndCritical();
+
+	for (ThreadObject **thread = this->threads.Begin(); thread != this->threads.End(); thread++) {
+		(*thread)->Join();
+		delete *thread;
+	}
+	delete this->mutex;
+}
+
+/**
+ * Main loop of the worker threads; execute tasks until the pool is destroyed.
+ * @param pool The pool the thread belongs to.
+ */
+/* static */ void WorkerPool::WorkerThread(void *pool)
+{
+	WorkerPool *self = (WorkerPool *)pool;
+
+	self->mutex->BeginCritical();
+	for (;;) {
+		while (self->queue.empty() && !self->exit) self->mutex->WaitForSignal();
+		if (self->exit) break;
+
+		Task task = self->queue.front();
+		self->queue.pop_front();
+		self->mutex->EndCritical();
+
+		task.func(task.data, task.begin, task.end);
+		task.batch->Finish();
+
+		self->mutex->BeginCritical();
+	}
+	self->mutex->EndCritical();
+}
+
+/**
+ * Execute a queued task of a batch in the calling thread.
+ * @param batch The batch to execute a task of.
+ * @return False when no task of the batch is queued anymore.
+ */
+bool WorkerPool::RunQueuedTask(WorkerPoolBatch *batch)
+{
+	this->mutex->BeginCritical();
+	std::deque<Task>::iterator it = this->queue.begin();
+	while (it != this->queue.end() && it->batch != batch) it++;
+	if (it == this->queue.end()) {
+		this->mutex->EndCritical();
+		return false;
+	}
+
+	Task task = *it;
+	this->queue.erase(it);
+	this->mutex->EndCritical();
+
+	task.func(task.data, task.begin, task.end);
+	batch->Finish();
+	return true;
+}
+
+/**
+ * Queue a loop for execution by the pool.
+ * @param func The function executing parts of the loop.
+ * @param data Data passed to \a func.
+ * @param count Number of iterations of the loop.
+ * @param chunks Maximum number of parts to split the loop into.
+ * @return The batch to pass to Wait(); every batch must be waited for.
+ */
+WorkerPoolBatch *WorkerPool::Post(WorkerPoolFunc func, void *data, uint count, uint chunks)
+{
+	WorkerPoolBatch *batch = new WorkerPoolBatch();
+	chunks = Clamp(chunks, 1U, max(count, 1U));
+
+	ThreadMutexLocker lock(this->mutex);
+	batch->remaining = chunks;
+	for (uint i = 0; i < chunks; i++) {
+		Task task;
+		task.func = func;
+		task.data = data;
+		task.begin = (uint)((uint64)count * i / chunks);
+		task.end = (uint)((uint64)count * (i + 1) / chunks);
+		task.batch = batch;
+		this->queue.push_back(task);
+		this->mutex->SendSignal();
+	}
+	return batch;
+}
+
+/**
+ * Wait until all tasks of a batch are done, executing the ones that are not picked up by a worker yet.
+ * @param batch The batch to wait for; it is freed.
+ */
+void WorkerPool::Wait(WorkerPoolBatch *batch)
+{
+	while (this->RunQueuedTask(batch)) {}
+
+	batch->mutex->BeginCritical();
+	while (batch->remaining > 0) batch->mutex->WaitForSignal();
+	batch->mutex->EndCritical();
+
+	delete batch;
+}
+
+/**
+ * Execute a loop in parallel and wait for it to finish.
+ * The iterations of the loop must be independent of each other.
+ * @param func The function executing parts of the loop.
+ * @param data Data passed to \a func.
+ * @param count Number of iterations of the loop.
+ * @param grain Minimum number of iterations worth handing to another thread.
+ */
+void WorkerPool::ParallelFor(WorkerPoolFunc func, void *data, uint count, uint grain)
+{
+	if (count == 0) return;
+
+	/* Several chunks per thread, so a thread that is slow to start does not hold back the others. */
+	uint chunks = min((this->threads.Length() + 1) * 4, CeilDiv(count, max(grain, 1U)));
+	if (chunks <= 1) {
+		func(data, 0, count);
+		return;
+	}
+
+	this->Wait(this->Post(func, data, count, chunks));
+}
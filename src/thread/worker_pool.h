@@ -0,0 +1,87 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_pool.h A pool of threads executing small tasks. */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include "thread.h"
+#include "../core/smallvec_type.hpp"
+#include <deque>
+
+/**
+ * Function executing a part of a parallel loop.
+ * @param data The data given to WorkerPool::ParallelFor.
+ * @param begin First index of the loop to handle.
+ * @param end One past the last index of the loop to handle.
+ */
+typedef void (*WorkerPoolFunc)(void *data, uint begin, uint end);
+
+/**
+ * A set of tasks somebody is waiting for.
+ * Users of the pool get these through WorkerPool::Post and must give them back to WorkerPool::Wait.
+ */
+class WorkerPoolBatch {
+	friend class WorkerPool;
+
+	ThreadMutex *mutex; ///< Mutex to protect the counter and to signal completion with.
+	uint remaining;     ///< Number of tasks of the batch that are not done yet.
+
+	WorkerPoolBatch();
+	~WorkerPoolBatch();
+	void Finish();
+
+public:
+	bool IsDone();
+};
+
+/**
+ * A fixed number of threads executing tasks from a shared queue.
+ * The thread waiting for tasks to finish helps executing queued tasks, so
+ * it does not matter whether the pool has any workers at all; tasks are
+ * then simply executed by the waiting thread.
+ */
+class WorkerPool {
+	/** A part of a loop that still needs to be executed. */
+	struct Task {
+		WorkerPoolFunc func;    ///< Function to call.
+		void *data;             ///< Data to pass to the function.
+		uint begin;             ///< First index to handle.
+		uint end;               ///< One past the last index to handle.
+		WorkerPoolBatch *batch; ///< Batch the task belongs to.
+	};
+
+	ThreadMutex *mutex;                     ///< Mutex protecting the queue and signalling new tasks.
+	std::deque<Task> queue;                 ///< Tasks that are not picked up yet.
+	SmallVector<ThreadObject *, 8> threads; ///< The worker threads.
+	bool exit;                              ///< Whether the workers should stop.
+
+	static void WorkerThread(void *pool);
+	bool RunQueuedTask(WorkerPoolBatch *batch);
+
+public:
+	WorkerPool(uint workers);
+	~WorkerPool();
+
+	/**
+	 * Get the number of threads of the pool, excluding the one waiting for a batch.
+	 * @return The number of worker threads.
+	 */
+	uint GetWorkerCount() const
+	{
+		return this->threads.Length();
+	}
+
+	WorkerPoolBatch *Post(WorkerPoolFunc func, void *data, uint count, uint chunks);
+	void Wait(WorkerPoolBatch *batch);
+	void ParallelFor(WorkerPoolFunc func, void *data, uint count, uint grain = 1);
+};
+
+#endif /* WORKER_POOL_H */
@@ -0,0 +1,148 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tick_profiler.cpp Measuring the time spent in the phases of the game loop. */
+
+#include "stdafx.h"
+#include "tick_profiler.h"
+#include "core/sort_func.hpp"
+
+#if defined(WIN32)
+#	include <windows.h> /* QueryPerformanceCounter */
+#else
+#	include <sys/time.h> /* gettimeofday */
+#endif
+
+#include "safeguards.h"
+
+/** Time spent per phase in each of the recorded ticks, in microseconds. */
+static uint32 _tick_profiler_samples[TPP_END][TICK_PROFILER_HISTORY];
+/** Position in the ring buffer of the tick that is being recorded. */
+static uint _tick_profiler_pos = 0;
+/** Number of ticks in the ring buffer that have been completely recorded. */
+static uint _tick_profiler_count = 0;
+/** Whether we are recording a tick, i.e. between TickProfilerBeginTick() and TickProfilerEndTick(). */
+static bool _tick_profiler_active = false;
+
+/** Names of the phases, as shown to the user. */
+static const char * const _tick_profiler_phase_names[] = {
+	"game loop",
+	"tile loop",
+	"vehicles",
+	"landscape",
+	"AIs",
+	"game script",
+};
+assert_compile(lengthof(_tick_profiler_phase_names) == TPP_END);
+
+/**
+ * Get a monotonic time with a resolution of (at most) a microsecond.
+ * @return The time in microseconds since some unspecified point in the past.
+ */
+uint64 GetProfilerTime()
+{
+#if defined(WIN32)
+	static LARGE_INTEGER frequency = { { 0, 0 } };
+	if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (uint64)counter.QuadPart * 1000000 / (uint64)frequency.QuadPart;
+#else
+	struct timeval tim;
+	gettimeofday(&tim, NULL);
+	return (uint64)tim.tv_sec * 1000000 + tim.tv_usec;
+#endif
+}
+
+/** Start recording a new tick, overwriting the oldest recorded one when the history is full. */
+void TickProfilerBeginTick()
+{
+	for (TickProfilerPhase phase = TPP_BEGIN; phase < TPP_END; phase++) {
+		_tick_profiler_samples[phase][_tick_profiler_pos] = 0;
+	}
+	_tick_profiler_active = true;
+}
+
+/** Finish recording the current tick. */
+void TickProfilerEndTick()
+{
+	if (!_tick_profiler_active) return;
+
+	_tick_profiler_active = false;
+	_tick_profiler_pos = (_tick_profiler_pos + 1) % TICK_PROFILER_HISTORY;
+	if (_tick_profiler_count < TICK_PROFILER_HISTORY) _tick_profiler_count++;
+}
+
+/**
+ * Account some time to a phase of the tick that is being recorded.
+ * Time measured outside of a recorded tick, e.g. while the game is paused, is ignored.
+ * @param phase The phase the time was spent in.
+ * @param time The spent time in microseconds.
+ */
+void TickProfilerAdd(TickProfilerPhase phase, uint64 time)
+{
+	if (!_tick_profiler_active) return;
+
+	uint32 &sample = _tick_profiler_samples[phase][_tick_profiler_pos];
+	sample = (uint32)min<uint64>((uint64)sample + time, UINT32_MAX);
+}
+
+/** Forget all recorded ticks. */
+void TickProfilerReset()
+{
+	_tick_profiler_count = 0;
+	_tick_profiler_pos = 0;
+	_tick_profiler_active = false;
+}
+
+/** Sort the samples in ascending order. */
+static int CDECL TickProfilerSampleSorter(const uint32 *a, const uint32 *b)
+{
+	return (*a > *b) - (*a < *b);
+}
+
+/**
+ * Get the statistics of a phase over the recorded ticks.
+ * @param phase The phase to get the statistics for.
+ * @param[out] stats The statistics; all zero when no ticks were recorded.
+ */
+void GetTickProfilerStats(TickProfilerPhase phase, TickProfilerStats *stats)
+{
+	MemSetT(stats, 0);
+	if (_tick_profiler_count == 0) return;
+
+	/* The oldest complete tick is just behind the one being written when the buffer is full. */
+	uint first = (_tick_profiler_pos + TICK_PROFILER_HISTORY - _tick_profiler_count) % TICK_PROFILER_HISTORY;
+
+	uint32 sorted[TICK_PROFILER_HISTORY];
+	uint64 sum = 0;
+	for (uint i = 0; i < _tick_profiler_count; i++) {
+		sorted[i] = _tick_profiler_samples[phase][(first + i) % TICK_PROFILER_HISTORY];
+		sum += sorted[i];
+	}
+	QSortT(sorted, _tick_profiler_count, &TickProfilerSampleSorter);
+
+	stats->samples = _tick_profiler_count;
+	stats->min = sorted[0];
+	stats->avg = (uint32)(sum / _tick_profiler_count);
+	stats->p99 = sorted[(_tick_profiler_count * 99 - 1) / 100];
+	stats->max = sorted[_tick_profiler_count - 1];
+}
+
+/**
+ * Get the name of a phase.
+ * @param phase The phase to get the name of.
+ * @return The human readable name.
+ */
+const char *GetTickProfilerPhaseName(TickProfilerPhase phase)
+{
+	assert(phase < TPP_END);
+	return _tick_profiler_phase_names[phase];
+}
@@ -0,0 +1,96 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tick_profiler.h Measuring the time spent in the phases of the game loop. */
+
+#ifndef TICK_PROFILER_H
+#define TICK_PROFILER_H
+
+#include "core/enum_type.hpp"
+
+/** The phases of a game tick that are measured by the tick profiler. */
+enum TickProfilerPhase {
+	TPP_BEGIN = 0,
+	TPP_STATE_GAME_LOOP = TPP_BEGIN, ///< The whole StateGameLoop().
+	TPP_TILE_LOOP,                   ///< RunTileLoop().
+	TPP_VEHICLE_TICKS,               ///< CallVehicleTicks().
+	TPP_LANDSCAPE_TICK,              ///< CallLandscapeTick(); towns, industries, stations and the link graph.
+	TPP_AI_GAME_LOOP,                ///< AI::GameLoop().
+	TPP_GS_GAME_LOOP,                ///< Game::GameLoop().
+	TPP_END,                         ///< End marker.
+};
+DECLARE_POSTFIX_INCREMENT(TickProfilerPhase)
+
+/** Number of ticks the tick profiler keeps the measurements of. */
+static const uint TICK_PROFILER_HISTORY = 512;
+
+/** Aggregated measurements of one phase over the recorded ticks; all times are in microseconds. */
+struct TickProfilerStats {
+	uint samples; ///< Number of ticks the statistics are based on.
+	uint32 min;   ///< Fastest tick.
+	uint32 avg;   ///< Average over all ticks.
+	uint32 p99;   ///< 99th percentile.
+	uint32 max;   ///< Slowest tick.
+};
+
+uint64 GetProfilerTime();
+
+void TickProfilerBeginTick();
+void TickProfilerEndTick();
+void TickProfilerAdd(TickProfilerPhase phase, uint64 time);
+void TickProfilerReset();
+void GetTickProfilerStats(TickProfilerPhase phase, TickProfilerStats *stats);
+const char *GetTickProfilerPhaseName(TickProfilerPhase phase);
+
+/**
+ * Measure the time between the construction and the destruction
+ * of this object and account it to a phase of the current tick.
+ */
+class TickProfilerScope {
+	TickProfilerPhase phase; ///< The phase to account the time to.
+	uint64 start;            ///< The time the measurement started.
+
+public:
+	/**
+	 * Start measuring a phase.
+	 * @param phase The phase to account the time to.
+	 */
+	TickProfilerScope(TickProfilerPhase phase) : phase(phase), start(GetProfilerTime()) {}
+
+	/** Stop measuring and account the time to the phase. */
+	~TickProfilerScope()
+	{
+		TickProfilerAdd(this->phase, GetProfilerTime() - this->start);
+	}
+};
+
+/**
+ * Record a tick of the game loop during the lifetime of this object,
+ * accounting the whole time to #TPP_STATE_GAME_LOOP.
+ */
+class TickProfilerTick {
+	uint64 start; ///< The time the tick started.
+
+public:
+	/** Start recording a tick. */
+	TickProfilerTick()
+	{
+		TickProfilerBeginTick();
+		this->start = GetProfilerTime();
+	}
+
+	/** Finish recording the tick. */
+	~TickProfilerTick()
+	{
+		TickProfilerAdd(TPP_STATE_GAME_LOOP, GetProfilerTime() - this->start);
+		TickProfilerEndTick();
+	}
+};
+
+#endif /* TICK_PROFILER_H */
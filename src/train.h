@@ -19,6 +19,7 @@
 #include "rail.h"
 #include "engine_base.h"
 #include "rail_map.h"
+#include "pbs.h"
 #include "ground_vehicle.hpp"
 
 struct Train;
@@ -68,6 +69,46 @@ int GetTrainStopLocation(StationID station_id, TileIndex tile, const Train *v, i
 
 void GetTrainSpriteSize(EngineID engine, uint &width, uint &height, int &xoffs, int &yoffs, EngineImageType image_type);
 
+/** Maximum number of junctions a train remembers the track choice for. */
+static const uint TRAIN_PATH_CACHE_SIZE = 8;
+
+/**
+ * The track choices at the next junctions on the path the pathfinder found for a train.
+ * When the train reaches these junctions before the choices expire, the pathfinder
+ * does not have to run again. The choices expire at a fixed tick, so all clients of
+ * a network game search a new path at the same time.
+ */
+struct TrainPathCache {
+	TileIndex tile[TRAIN_PATH_CACHE_SIZE];  ///< Junction tiles, in the order the train reaches them.
+	TrackdirByte td[TRAIN_PATH_CACHE_SIZE]; ///< Trackdir to take at each of the junctions.
+	byte next;                              ///< Index of the next junction the train reaches.
+	byte count;                             ///< Number of junctions the choice is known for.
+	byte order_type;                        ///< Type of the order the path was searched for.
+	DestinationID order_dest;               ///< Destination of the order the path was searched for.
+	uint16 expire;                          ///< Value of #_tick_counter at which the choices expire.
+
+	/** Forget all choices. */
+	inline void Clear()
+	{
+		this->next = this->count = 0;
+	}
+};
+
+/**
+ * The end of the reservation of a train. It stays valid until the train
+ * moves or any reservation or track changes, as a reservation can be
+ * followed into the reservation of another train.
+ */
+struct TrainReservationCache {
+	TileIndex start;       ///< Tile of the train when the reservation was followed.
+	Trackdir start_td;     ///< Trackdir of the train when the reservation was followed.
+	Owner owner;           ///< Owner of the train when the reservation was followed.
+	RailType railtype;     ///< Rail type of the train when the reservation was followed.
+	bool forbid_90deg;     ///< Whether 90 degree turns were forbidden when checking the end.
+	uint32 version;        ///< Value of #_reservation_version when the reservation was followed.
+	PBSTileInfo end;       ///< The end of the reservation.
+};
+
 /** Variables that are cached to improve performance and such */
 struct TrainCache {
 	/* Cached wagon override spritegroup */
@@ -102,6 +143,9 @@ struct Train FINAL : public GroundVehicle<Train, VEH_TRAIN> {
 	/** Ticks waiting in front of a signal, ticks being stuck or a counter for forced proceeding through signals. */
 	uint16 wait_counter;
 
+	TrainPathCache path_cache; ///< Track choices at the next junctions.
+	mutable TrainReservationCache reservation_cache; ///< End of the reservation of the train.
+
 	/** We don't want GCC to zero our struct! It already is zeroed and has an index! */
 	Train() : GroundVehicleBase() {}
 	/** We want to 'destruct' the right class. */
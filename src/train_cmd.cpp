@@ -2165,6 +2165,7 @@ static bool CheckTrainStayInDepot(Train *v)
 		/* We need to have a reservation for this to work. */
 		if (HasDepotReservation(v->tile)) return true;
 		SetDepotReservation(v->tile, true);
+		MarkReservationsChanged();
 		VehicleEnterDepot(v);
 		return true;
 	}
@@ -2178,6 +2179,7 @@ static bool CheckTrainStayInDepot(Train *v)
 	}
 
 	SetDepotReservation(v->tile, true);
+	MarkReservationsChanged();
 	if (_settings_client.gui.show_track_reservation) MarkTileDirtyByTile(v->tile);
 
 	VehicleServiceInDepot(v);
@@ -2218,6 +2220,7 @@ static void ClearPathReservation(const Train *v, TileIndex tile, Trackdir track_
 				/* Free the reservation only if no other train is on the tiles. */
 				SetTunnelBridgeReservation(tile, false);
 				SetTunnelBridgeReservation(end, false);
+				MarkReservationsChanged();
 
 				if (_settings_client.gui.show_track_reservation) {
 					if (IsBridge(tile)) {
@@ -2313,6 +2316,35 @@ static const byte _initial_tile_subcoord[6][4][3] = {
 {{  0, 0, 0 }, { 0, 0, 0 }, { 0, 8, 4 }, { 7, 15, 0 }},
 };
 
+/**
+ * Get the track a train chose for a junction during an earlier path search.
+ * The remembered choices are forgotten when they do not fit the junction.
+ * @param v The train.
+ * @param tile The junction the train enters.
+ * @param enterdir The direction the train enters the junction from.
+ * @param tracks The tracks the train can choose from.
+ * @return The track to take, or INVALID_TRACK when a path search is needed.
+ */
+static Track GetCachedTrainPath(Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks)
+{
+	TrainPathCache &cache = v->path_cache;
+	if (cache.next >= cache.count) return INVALID_TRACK;
+
+	if ((int16)(cache.expire - _tick_counter) <= 0 || cache.tile[cache.next] != tile ||
+			cache.order_type != v->current_order.GetType() || cache.order_dest != v->current_order.GetDestination()) {
+		cache.Clear();
+		return INVALID_TRACK;
+	}
+
+	Trackdir td = cache.td[cache.next++];
+	Track track = TrackdirToTrack(td);
+	if (!HasBit(tracks, track) || TrackEnterdirToTrackdir(track, enterdir) != td) {
+		cache.Clear();
+		return INVALID_TRACK;
+	}
+	return track;
+}
+
 /**
  * Perform pathfinding for a train.
  *
@@ -2325,14 +2357,33 @@ static const byte _initial_tile_subcoord[6][4][3] = {
  * @param dest [out] State and destination of the requested path
  * @return The best track the train should follow
  */
-static Track DoTrainPathfind(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool do_track_reservation, PBSTileInfo *dest)
+static Track DoTrainPathfind(Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool do_track_reservation, PBSTileInfo *dest)
 {
+	Track track;
 	switch (_settings_game.pf.pathfinder_for_trains) {
-		case VPF_NPF: return NPFTrainChooseTrack(v, tile, enterdir, tracks, path_found, do_track_reservation, dest);
-		case VPF_YAPF: return YapfTrainChooseTrack(v, tile, enterdir, tracks, path_found, do_track_reservation, dest);
+		case VPF_NPF: track = NPFTrainChooseTrack(v, tile, enterdir, tracks, path_found, do_track_reservation, dest); break;
+		case VPF_YAPF:
+			/* Reserving paths need an up to date search. */
+			if (do_track_reservation || _settings_game.pf.yapf.rail_path_cache_junctions == 0) {
+				track = YapfTrainChooseTrack(v, tile, enterdir, tracks, path_found, do_track_reservation, dest);
+				break;
+			}
+
+			track = GetCachedTrainPath(v, tile, enterdir, tracks);
+			if (track != INVALID_TRACK) {
+				path_found = true;
+				return track;
+			}
+
+			v->path_cache.Clear();
+			track = YapfTrainChooseTrack(v, tile, enterdir, tracks, path_found, false, dest, &v->path_cache);
+			break;
 
 		default: NOT_REACHED();
 	}
+
+	if (_pf_capture_active) PathfinderCaptureQuery(PFQ_TRAIN, v, tile, enterdir, tracks, do_track_reservation, track, path_found);
+	return track;
 }
 
 /**
@@ -2725,6 +2776,7 @@ bool TryPathReserve(Train *v, bool mark_as_stuck, bool first_tile_okay)
 	/* If we are in a depot, tentatively reserve the depot. */
 	if (v->track == TRACK_BIT_DEPOT) {
 		SetDepotReservation(v->tile, true);
+		MarkReservationsChanged();
 		if (_settings_client.gui.show_track_reservation) MarkTileDirtyByTile(v->tile);
 	}
 
@@ -2739,7 +2791,10 @@ bool TryPathReserve(Train *v, bool mark_as_stuck, bool first_tile_okay)
 
 	if (!res_made) {
 		/* Free the depot reservation as well. */
-		if (v->track == TRACK_BIT_DEPOT) SetDepotReservation(v->tile, false);
+		if (v->track == TRACK_BIT_DEPOT) {
+			SetDepotReservation(v->tile, false);
+			MarkReservationsChanged();
+		}
 		return false;
 	}
 
@@ -2949,6 +3004,7 @@ uint Train::Crash(bool flooded)
 				/* ClearPathReservation will not free the wormhole exit
 				 * if the train has just entered the wormhole. */
 				SetTunnelBridgeReservation(GetOtherTunnelBridgeEnd(v->tile), false);
+				MarkReservationsChanged();
 			}
 		}
 
@@ -517,6 +517,8 @@ CommandCost CmdBuildBridge(TileIndex end_tile, DoCommandFlag flags, uint32 p1, u
 				Owner owner_tram = HasBit(prev_roadtypes, ROADTYPE_TRAM) ? GetRoadOwner(tile_start, ROADTYPE_TRAM) : company;
 				MakeRoadBridgeRamp(tile_start, owner, owner_road, owner_tram, bridge_type, dir,                 roadtypes);
 				MakeRoadBridgeRamp(tile_end,   owner, owner_road, owner_tram, bridge_type, ReverseDiagDir(dir), roadtypes);
+				YapfNotifyRoadLayoutChange(tile_start);
+				YapfNotifyRoadLayoutChange(tile_end);
 				break;
 			}
 
@@ -524,6 +526,8 @@ CommandCost CmdBuildBridge(TileIndex end_tile, DoCommandFlag flags, uint32 p1, u
 				if (is_new_owner && c != NULL) c->infrastructure.water += (bridge_len + 2) * TUNNELBRIDGE_TRACKBIT_FACTOR;
 				MakeAqueductBridgeRamp(tile_start, owner, dir);
 				MakeAqueductBridgeRamp(tile_end,   owner, ReverseDiagDir(dir));
+				YapfNotifyWaterLayoutChange(tile_start);
+				YapfNotifyWaterLayoutChange(tile_end);
 				break;
 
 			default:
@@ -733,6 +737,8 @@ CommandCost CmdBuildTunnel(TileIndex start_tile, DoCommandFlag flags, uint32 p1,
 			}
 			MakeRoadTunnel(start_tile, company, direction,                 rts);
 			MakeRoadTunnel(end_tile,   company, ReverseDiagDir(direction), rts);
+			YapfNotifyRoadLayoutChange(start_tile);
+			YapfNotifyRoadLayoutChange(end_tile);
 		}
 		DirtyCompanyInfrastructureWindows(company);
 	}
@@ -865,6 +871,8 @@ static CommandCost DoClearTunnel(TileIndex tile, DoCommandFlag flags)
 
 			DoClearSquare(tile);
 			DoClearSquare(endtile);
+			YapfNotifyRoadLayoutChange(tile);
+			YapfNotifyRoadLayoutChange(endtile);
 		}
 	}
 	return CommandCost(EXPENSES_CONSTRUCTION, _price[PR_CLEAR_TUNNEL] * len);
@@ -934,8 +942,12 @@ static CommandCost DoClearBridge(TileIndex tile, DoCommandFlag flags)
 					DirtyCompanyInfrastructureWindows(c->index);
 				}
 			}
+			YapfNotifyRoadLayoutChange(tile);
+			YapfNotifyRoadLayoutChange(endtile);
 		} else { // Aqueduct
 			if (Company::IsValidID(owner)) Company::Get(owner)->infrastructure.water -= len * TUNNELBRIDGE_TRACKBIT_FACTOR;
+			YapfNotifyWaterLayoutChange(tile);
+			YapfNotifyWaterLayoutChange(endtile);
 		}
 		DirtyCompanyInfrastructureWindows(owner);
 
@@ -300,32 +300,82 @@ byte VehicleRandomBits()
 	return GB(Random(), 0, 8);
 }
 
-/* Size of the hash, 6 = 64 x 64, 7 = 128 x 128. Larger sizes will (in theory) reduce hash
- * lookup times at the expense of memory usage. */
-const int HASH_BITS = 7;
-const int HASH_SIZE = 1 << HASH_BITS;
-const int HASH_MASK = HASH_SIZE - 1;
-const int TOTAL_HASH_SIZE = 1 << (HASH_BITS * 2);
-const int TOTAL_HASH_MASK = TOTAL_HASH_SIZE - 1;
+/* The tile hash is a grid with a bucket per tile, wrapping around when the map
+ * is larger than the grid. The grid is sized from the map, up to 2^(2 * TILE_HASH_MAX_BITS)
+ * buckets, so on all but the largest maps every bucket only contains the vehicles of a
+ * single tile. */
+static const uint TILE_HASH_MAX_BITS = 10; ///< Maximum number of bits of a coordinate used for the tile hash.
 
-/* Resolution of the hash, 0 = 1*1 tile, 1 = 2*2 tiles, 2 = 4*4 tiles, etc.
- * Profiling results show that 0 is fastest. */
-const int HASH_RES = 0;
+static Vehicle **_vehicle_tile_hash = NULL; ///< The buckets of the tile hash.
+static uint _vehicle_tile_hash_bits_x = 0;  ///< Number of bits of the X coordinate used for the tile hash.
+static uint _vehicle_tile_hash_bits_y = 0;  ///< Number of bits of the Y coordinate used for the tile hash.
 
-static Vehicle *_vehicle_tile_hash[TOTAL_HASH_SIZE];
+/**
+ * Get the bucket of the tile hash of a tile position.
+ * @param x X coordinate of the tile.
+ * @param y Y coordinate of the tile.
+ * @return The bucket.
+ */
+static inline Vehicle **GetVehicleTileHashBucket(uint x, uint y)
+{
+	x &= (1 << _vehicle_tile_hash_bits_x) - 1;
+	y &= (1 << _vehicle_tile_hash_bits_y) - 1;
+	return &_vehicle_tile_hash[(y << _vehicle_tile_hash_bits_x) | x];
+}
 
-static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, void *data, VehicleFromPosProc *proc, bool find_first)
+/**
+ * Resize the tile hash to the size of the current map and empty it.
+ * Vehicles have to be (re)added to the hash by the caller.
+ */
+static void ResetVehicleTileHash()
 {
-	for (int y = yl; ; y = (y + (1 << HASH_BITS)) & (HASH_MASK << HASH_BITS)) {
-		for (int x = xl; ; x = (x + 1) & HASH_MASK) {
-			Vehicle *v = _vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
+	uint bits_x = min(MapLogX(), TILE_HASH_MAX_BITS);
+	uint bits_y = min(MapLogY(), TILE_HASH_MAX_BITS);
+
+	if (_vehicle_tile_hash == NULL || bits_x != _vehicle_tile_hash_bits_x || bits_y != _vehicle_tile_hash_bits_y) {
+		free(_vehicle_tile_hash);
+		_vehicle_tile_hash = MallocT<Vehicle *>(1 << (bits_x + bits_y));
+		_vehicle_tile_hash_bits_x = bits_x;
+		_vehicle_tile_hash_bits_y = bits_y;
+	}
+	MemSetT(_vehicle_tile_hash, 0, 1 << (bits_x + bits_y));
+}
+
+/**
+ * Helper function for the queries of vehicles in a rectangle of tiles.
+ * Every bucket of the rectangle is visited once, even when the rectangle is larger than the hash.
+ * @note Do not call this function directly!
+ * @param xl   The lowest X coordinate of the tiles to look at.
+ * @param yl   The lowest Y coordinate of the tiles to look at.
+ * @param xu   The highest X coordinate of the tiles to look at.
+ * @param yu   The highest Y coordinate of the tiles to look at.
+ * @param data Arbitrary data passed to proc
+ * @param proc The proc that determines whether a vehicle will be "found".
+ * @param find_first Whether to return on the first found or iterate over
+ *                   all vehicles
+ * @param only_area Whether to only pass vehicles on a tile of the rectangle to \a proc,
+ *                  instead of all vehicles in the visited buckets.
+ * @return the best matching or first vehicle (depending on find_first).
+ */
+static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, void *data, VehicleFromPosProc *proc, bool find_first, bool only_area)
+{
+	uint w = min<uint>(xu - xl + 1, 1 << _vehicle_tile_hash_bits_x);
+	uint h = min<uint>(yu - yl + 1, 1 << _vehicle_tile_hash_bits_y);
+
+	for (uint dy = 0; dy < h; dy++) {
+		for (uint dx = 0; dx < w; dx++) {
+			Vehicle *v = *GetVehicleTileHashBucket(xl + dx, yl + dy);
 			for (; v != NULL; v = v->hash_tile_next) {
+				if (only_area) {
+					int x = TileX(v->tile);
+					int y = TileY(v->tile);
+					if (x < xl || x > xu || y < yl || y > yu) continue;
+				}
+
 				Vehicle *a = proc(v, data);
 				if (find_first && a != NULL) return a;
 			}
-			if (x == xu) break;
 		}
-		if (y == yu) break;
 	}
 
 	return NULL;
@@ -347,13 +397,13 @@ static Vehicle *VehicleFromPosXY(int x, int y, void *data, VehicleFromPosProc *p
 {
 	const int COLL_DIST = 6;
 
-	/* Hash area to scan is from xl,yl to xu,yu */
-	int xl = GB((x - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS);
-	int xu = GB((x + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS);
-	int yl = GB((y - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
-	int yu = GB((y + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
+	/* Tile area to scan is from xl,yl to xu,yu */
+	int xl = (x - COLL_DIST) / (int)TILE_SIZE;
+	int xu = (x + COLL_DIST) / (int)TILE_SIZE;
+	int yl = (y - COLL_DIST) / (int)TILE_SIZE;
+	int yu = (y + COLL_DIST) / (int)TILE_SIZE;
 
-	return VehicleFromTileHash(xl, yl, xu, yu, data, proc, find_first);
+	return VehicleFromTileHash(xl, yl, xu, yu, data, proc, find_first, false);
 }
 
 /**
@@ -403,10 +453,7 @@ bool HasVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc)
  */
 static Vehicle *VehicleFromPos(TileIndex tile, void *data, VehicleFromPosProc *proc, bool find_first)
 {
-	int x = GB(TileX(tile), HASH_RES, HASH_BITS);
-	int y = GB(TileY(tile), HASH_RES, HASH_BITS) << HASH_BITS;
-
-	Vehicle *v = _vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
+	Vehicle *v = *GetVehicleTileHashBucket(TileX(tile), TileY(tile));
 	for (; v != NULL; v = v->hash_tile_next) {
 		if (v->tile != tile) continue;
 
@@ -450,6 +497,38 @@ bool HasVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc)
 	return VehicleFromPos(tile, data, proc, true) != NULL;
 }
 
+/**
+ * Find the vehicles on the tiles of an area. It will call \a proc for ALL vehicles
+ * in the area, with the same caveats as #FindVehicleOnPos.
+ * This visits every bucket of the tile hash only once, instead of once per tile.
+ * @param ta   The area on the map.
+ * @param data Arbitrary data passed to \a proc.
+ * @param proc The proc that determines whether a vehicle will be "found".
+ */
+void FindVehicleOnTileArea(const TileArea &ta, void *data, VehicleFromPosProc *proc)
+{
+	if (ta.w == 0 || ta.h == 0) return;
+	int x = TileX(ta.tile);
+	int y = TileY(ta.tile);
+	VehicleFromTileHash(x, y, x + ta.w - 1, y + ta.h - 1, data, proc, false, true);
+}
+
+/**
+ * Checks whether a vehicle is on any of the tiles of an area. It will call \a proc for
+ * vehicles until it returns non-NULL.
+ * @param ta   The area on the map.
+ * @param data Arbitrary data passed to \a proc.
+ * @param proc The \a proc that determines whether a vehicle will be "found".
+ * @return True if proc returned non-NULL.
+ */
+bool HasVehicleOnTileArea(const TileArea &ta, void *data, VehicleFromPosProc *proc)
+{
+	if (ta.w == 0 || ta.h == 0) return false;
+	int x = TileX(ta.tile);
+	int y = TileY(ta.tile);
+	return VehicleFromTileHash(x, y, x + ta.w - 1, y + ta.h - 1, data, proc, true, true) != NULL;
+}
+
 /**
  * Callback that returns 'real' vehicles lower or at height \c *(int*)data .
  * @param v Vehicle to examine.
@@ -552,9 +631,7 @@ static void UpdateVehicleTileHash(Vehicle *v, bool remove)
 	if (remove) {
 		new_hash = NULL;
 	} else {
-		int x = GB(TileX(v->tile), HASH_RES, HASH_BITS);
-		int y = GB(TileY(v->tile), HASH_RES, HASH_BITS) << HASH_BITS;
-		new_hash = &_vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
+		new_hash = GetVehicleTileHashBucket(TileX(v->tile), TileY(v->tile));
 	}
 
 	if (old_hash == new_hash) return;
@@ -610,7 +687,7 @@ void ResetVehicleHash()
 	Vehicle *v;
 	FOR_ALL_VEHICLES(v) { v->hash_tile_current = NULL; }
 	memset(_vehicle_viewport_hash, 0, sizeof(_vehicle_viewport_hash));
-	memset(_vehicle_tile_hash, 0, sizeof(_vehicle_tile_hash));
+	ResetVehicleTileHash();
 }
 
 void ResetVehicleColourMap()
@@ -1365,6 +1442,7 @@ void VehicleEnterDepot(Vehicle *v)
 			SetWindowClassesDirty(WC_TRAINS_LIST);
 			/* Clear path reservation */
 			SetDepotReservation(t->tile, false);
+			MarkReservationsChanged();
 			if (_settings_client.gui.show_track_reservation) MarkTileDirtyByTile(t->tile);
 
 			UpdateSignalsOnSegment(t->tile, INVALID_DIAGDIR, t->owner);
@@ -18,6 +18,7 @@
 #include <set>
 #include <algorithm>
 #include <limits>
+#include <tuple>
 
 #include "../vehicle_base.h"
 #include "../station_base.h"
@@ -37,10 +38,21 @@
 /** Factory for the graph video driver. */
 static FVideoDriver_Railnet iFVideoDriver_Railnet;
 
-VideoDriver_Railnet::VideoDriver_Railnet()
+VideoDriver_Railnet::VideoDriver_Railnet() : compact(false), binary(false)
 {
 }
 
+const char *VideoDriver_Railnet::Start(const char * const *parm)
+{
+	this->compact = GetDriverParamBool(parm, "compact");
+	const char *format = GetDriverParam(parm, "format");
+	if (format != NULL && strcmp(format, "json") != 0) {
+		if (strcmp(format, "binary") != 0) return "unknown railnet format, use 'json' or 'binary'";
+		this->binary = true;
+	}
+	return VideoDriver_Null::Start(parm);
+}
+
 //template<class T> ... (function)
 
 //! tile + trackdir
@@ -215,6 +227,139 @@ bool ForAllStationsTo(const Train* train, location_data location, const Order& o
 	return path_found;
 }
 
+//! everything the cost of a path computed by ForAllStationsTo() depends on,
+//! apart from the map itself
+//! @note YAPF aims its estimate at the station tile closest to the train,
+//!   which is left out here: it only decides between equally cheap paths
+struct path_key_t {
+	TileIndex tile;
+	Trackdir dir;
+	OrderType order_type;
+	DestinationID dest;
+	RailType railtype;
+	RailTypes compatible_railtypes;
+	Owner owner;
+	uint16 total_length; //!< for the platform length penalties
+	uint max_speed; //!< for the speed limit penalties
+	DestinationID waypoint; //!< waypoint the train heads for in the game
+
+	path_key_t(const Train* train, location_data location, const Order& order) :
+		tile(location.tile),
+		dir(location.dir),
+		order_type(order.GetType()),
+		dest(order.GetDestination()),
+		railtype(train->railtype),
+		compatible_railtypes(train->compatible_railtypes),
+		owner(train->owner),
+		total_length(train->gcache.cached_total_length),
+		max_speed(train->GetDisplayMaxSpeed()),
+		waypoint(train->current_order.IsType(OT_GOTO_WAYPOINT)
+			? train->current_order.GetDestination() : INVALID_STATION)
+	{
+	}
+
+	bool operator<(const path_key_t& other) const
+	{
+		return std::tie(tile, dir, order_type, dest, railtype,
+				compatible_railtypes, owner, total_length, max_speed, waypoint)
+			< std::tie(other.tile, other.dir, other.order_type, other.dest,
+				other.railtype, other.compatible_railtypes,
+				other.owner, other.total_length, other.max_speed,
+				other.waypoint);
+	}
+};
+
+/**
+	Memoizes the results of ForAllStationsTo() across trains. Many trains
+	share the same station pairs, and every path would otherwise be
+	recomputed by YAPF for each of them.
+*/
+class PathCacheT {
+	//! one node of a cached path, from the first node to the target
+	struct path_node_t {
+		TileIndex tile;
+		Trackdir dir;
+		StationID sid;
+	};
+
+	struct cached_path_t {
+		bool path_found;
+		std::vector<path_node_t> nodes;
+	};
+
+	std::map<path_key_t, cached_path_t> paths;
+
+	static bool Record(const visited_path_t& visited_path, std::vector<path_node_t>* nodes);
+	static void Replay(const std::vector<path_node_t>& nodes, visited_path_t* visited_path);
+public:
+	std::size_t hits = 0, misses = 0;
+
+	bool ForAllStationsTo(const Train *train, location_data location,
+		const Order& order, visited_path_t* visited_path);
+};
+
+/**
+	Extracts the path from @a visited_path like ForAllStationsOnPath() walks it
+	@return false if the path can not be walked (i.e. it contains a cycle)
+*/
+bool PathCacheT::Record(const visited_path_t& visited_path, std::vector<path_node_t>* nodes)
+{
+	if (!visited_path.first || !visited_path.target)
+	 return false;
+
+	std::size_t max = visited_path.path.size() << 1;
+	for (const st_node_t* from = visited_path.first; ; from = from->child) {
+		nodes->push_back(path_node_t { from->tile, from->dir, from->sid });
+		if (from == visited_path.target)
+		 return true;
+		if (!--max)
+		 return false;
+	}
+}
+
+//! writes a recorded path into @a visited_path like ForAllStationsTo() would
+void PathCacheT::Replay(const std::vector<path_node_t>& nodes, visited_path_t* visited_path)
+{
+	st_node_t* prev = NULL;
+	for (const path_node_t& n : nodes) {
+		st_node_t& st_node = visited_path->path[std::make_pair(n.tile, n.dir)];
+		st_node.tile = n.tile;
+		st_node.dir = n.dir;
+		st_node.sid = n.sid;
+		if (prev)
+		 prev->child = &st_node;
+		else
+		 visited_path->first = &st_node;
+		prev = &st_node;
+	}
+	visited_path->target = prev;
+}
+
+bool PathCacheT::ForAllStationsTo(const Train* train, location_data location,
+	const Order& order, visited_path_t* visited_path)
+{
+	// paths from the train's own position can not be shared
+	if (location.tile == INVALID_TILE)
+	 return ::ForAllStationsTo(train, location, order, visited_path);
+
+	path_key_t key(train, location, order);
+	std::map<path_key_t, cached_path_t>::const_iterator itr = paths.find(key);
+	if (itr != paths.end()) {
+		++hits;
+		if (itr->second.path_found)
+		 Replay(itr->second.nodes, visited_path);
+		return itr->second.path_found;
+	}
+
+	++misses;
+	bool path_found = ::ForAllStationsTo(train, location, order, visited_path);
+	cached_path_t cached;
+	cached.path_found = path_found;
+	if (!path_found || Record(*visited_path, &cached.nodes))
+	 paths.insert(std::make_pair(key, std::move(cached)));
+	return path_found;
+}
+
 struct DumpStation {
 	void operator()(const st_node_t& node) const
 	{
@@ -272,7 +417,8 @@ public:
 
 void VideoDriver_Railnet::SaveOrderList(comm::RailnetFileInfo& file, const Train* train,
 	std::vector<bool>& stations_used, std::set<CargoLabel>& cargo_used,
-	std::set<const OrderList*>& order_lists_done, NodeListT& node_list) const
+	std::set<const OrderList*>& order_lists_done, NodeListT& node_list,
+	PathCacheT& path_cache) const
 {
 	comm::OrderList new_ol;
 
@@ -372,7 +518,7 @@ void VideoDriver_Railnet::SaveOrderList(comm::RailnetFileInfo& file, const Train
 					std::cerr << "Recent loc: " << recent_loc.tile
 						<< " / " << recent_loc.dir << std::endl;
 #endif
-					path_found = ForAllStationsTo(train, recent_loc, *order,
+					path_found = path_cache.ForAllStationsTo(train, recent_loc, *order,
 						&visited_path);
 					ForAllStationsOnPath(visited_path, dump_station);
 #ifdef DEBUG_GRAPH_YAPF
@@ -401,7 +547,7 @@ void VideoDriver_Railnet::SaveOrderList(comm::RailnetFileInfo& file, const Train
 #ifdef DEBUG_GRAPH_YAPF
 					std::cerr << "Heading for station: " << buf << std::endl;
 #endif
-					path_found = ForAllStationsTo(train, recent_loc,
+					path_found = path_cache.ForAllStationsTo(train, recent_loc,
 						*order, &visited_path);
 
 					AddStation add_stations(order->GetNonStopType(), visited_path, &new_ol);
@@ -503,7 +649,7 @@ void VideoDriver_Railnet::SaveOrderList(comm::RailnetFileInfo& file, const Train
 
 			// get the order list with the ID from matches
 			// unfortunately, we need to look it up by scanning the whole order list...
-			for(std::list<comm::OrderList>::iterator it = file.order_lists().begin();
+			for(std::vector<comm::OrderList>::iterator it = file.order_lists().begin();
 				it != file.order_lists().end() && !match; ++it)
 			// for(auto it2 = it->cargo().begin(); it2 != it->cargo().end(); ++it2)
 			{
@@ -678,13 +824,16 @@ void VideoDriver_Railnet::MainLoop()
 	std::set<const OrderList*> order_lists_done;
 	std::cerr << "Calculating order lists... ";
 	NodeListT node_list;
+	PathCacheT path_cache;
 	FOR_ALL_TRAINS(train) {
 		std::cerr << std::setw(3) << cur_train*100/n_trains << "%";
-		SaveOrderList(file, train, stations_used, cargo_used, order_lists_done, node_list);
+		SaveOrderList(file, train, stations_used, cargo_used, order_lists_done, node_list, path_cache);
 		std::cerr << "\b\b\b\b";
 		++cur_train;
 	}
 	std::cerr << "100%" << std::endl;
+	std::cerr << "Paths: " << path_cache.misses << " computed, "
+		<< path_cache.hits << " reused" << std::endl;
 
 	// did we forget any order list?
 	bool any_problems = false;
@@ -717,7 +866,10 @@ void VideoDriver_Railnet::MainLoop()
 	//comm::json_ofile(std::cout) << comm::smem<comm::RailnetFileInfo, comm::s_railnet>(file);
 
 	// comm::prechecks(file);
-	comm::RailnetOfile(std::cout) << file;
+	if(binary)
+	 comm::WriteRailnetBinary(std::cout, file);
+	else
+	 comm::RailnetOfile(std::cout, compact) << file;
 }
 
 #endif // C++11 support
@@ -24,17 +24,21 @@ namespace comm {
 
 /**
  * Video driver that does not blit. Instead, it outputs a
- * railnet json file.
+ * railnet json (or binary) file.
  */
 class VideoDriver_Railnet : public VideoDriver_Null {
+	bool compact; ///< Whether to write the json file without line breaks and indentation.
+	bool binary;  ///< Whether to write the binary format instead of json.
+
 	void SaveOrderList(comm::RailnetFileInfo& file, const Train *train,
 		std::vector<bool> &stations_used, std::set<CargoLabel> &cargo_used, std::set<const OrderList *> &order_lists_done,
-		class NodeListT& node_list) const;
+		class NodeListT& node_list, class PathCacheT& path_cache) const;
 	void SaveStation(comm::RailnetFileInfo& file, const struct BaseStation* st,
 		const std::vector<bool> &stations_used) const;
 	void SaveCargoLabels(comm::RailnetFileInfo &file, std::set<CargoLabel> &s) const;
 public:
 	VideoDriver_Railnet();
+	/* virtual */ const char *Start(const char * const *param);
 	/* virtual */ void MainLoop();
 
 	/* virtual */ const char *GetName() const { return "railnet"; }
@@ -39,6 +39,7 @@
 #include "company_base.h"
 #include "company_gui.h"
 #include "newgrf_generic.h"
+#include "pathfinder/yapf/yapf_cache.h"
 
 #include "table/strings.h"
 
@@ -150,6 +151,8 @@ CommandCost CmdBuildShipDepot(TileIndex tile, DoCommandFlag flags, uint32 p1, ui
 		MakeShipDepot(tile2, _current_company, depot->index, DEPOT_PART_SOUTH, axis, wc2);
 		MarkTileDirtyByTile(tile);
 		MarkTileDirtyByTile(tile2);
+		YapfNotifyWaterLayoutChange(tile);
+		YapfNotifyWaterLayoutChange(tile2);
 		MakeDefaultName(depot);
 	}
 
@@ -205,6 +208,7 @@ void MakeWaterKeepingClass(TileIndex tile, Owner o)
 	}
 
 	MarkTileDirtyByTile(tile);
+	YapfNotifyWaterLayoutChange(tile);
 }
 
 static CommandCost RemoveShipDepot(TileIndex tile, DoCommandFlag flags)
@@ -306,6 +310,9 @@ static CommandCost DoBuildLock(TileIndex tile, DiagDirection dir, DoCommandFlag
 		MarkTileDirtyByTile(tile);
 		MarkTileDirtyByTile(tile - delta);
 		MarkTileDirtyByTile(tile + delta);
+		YapfNotifyWaterLayoutChange(tile);
+		YapfNotifyWaterLayoutChange(tile - delta);
+		YapfNotifyWaterLayoutChange(tile + delta);
 		MarkCanalsAndRiversAroundDirty(tile - delta);
 		MarkCanalsAndRiversAroundDirty(tile + delta);
 	}
@@ -348,6 +355,7 @@ static CommandCost RemoveLock(TileIndex tile, DoCommandFlag flags)
 		} else {
 			DoClearSquare(tile);
 		}
+		YapfNotifyWaterLayoutChange(tile);
 		MakeWaterKeepingClass(tile + delta, GetTileOwner(tile + delta));
 		MakeWaterKeepingClass(tile - delta, GetTileOwner(tile - delta));
 		MarkCanalsAndRiversAroundDirty(tile);
@@ -449,6 +457,7 @@ CommandCost CmdBuildCanal(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 			}
 			MarkTileDirtyByTile(tile);
 			MarkCanalsAndRiversAroundDirty(tile);
+			YapfNotifyWaterLayoutChange(tile);
 		}
 
 		cost.AddCost(_price[PR_BUILD_CANAL]);
@@ -491,6 +500,7 @@ static CommandCost ClearTile_Water(TileIndex tile, DoCommandFlag flags)
 				}
 				DoClearSquare(tile);
 				MarkCanalsAndRiversAroundDirty(tile);
+				YapfNotifyWaterLayoutChange(tile);
 			}
 
 			return CommandCost(EXPENSES_CONSTRUCTION, base_cost);
@@ -506,6 +516,7 @@ static CommandCost ClearTile_Water(TileIndex tile, DoCommandFlag flags)
 			if (flags & DC_EXEC) {
 				DoClearSquare(tile);
 				MarkCanalsAndRiversAroundDirty(tile);
+				YapfNotifyWaterLayoutChange(tile);
 			}
 			if (IsSlopeWithOneCornerRaised(slope)) {
 				return CommandCost(EXPENSES_CONSTRUCTION, _price[PR_CLEAR_WATER]);
@@ -966,6 +977,21 @@ static Vehicle *FloodVehicleProc(Vehicle *v, void *data)
 	return NULL;
 }
 
+/**
+ * Flood a vehicle on the ground of an airport.
+ * @param v    The vehicle to test for flooding.
+ * @param data The station of the airport.
+ * @return NULL as we always want to remove everything.
+ */
+static Vehicle *FloodAirportVehicleProc(Vehicle *v, void *data)
+{
+	const Station *st = (const Station *)data;
+	if (!st->TileBelongsToAirport(v->tile)) return NULL;
+
+	int z = 0;
+	return FloodVehicleProc(v, &z);
+}
+
 /**
  * Finds a vehicle to flood.
  * It does not find vehicles that are already crashed on bridges, i.e. flooded.
@@ -977,9 +1003,7 @@ static void FloodVehicles(TileIndex tile)
 
 	if (IsAirportTile(tile)) {
 		const Station *st = Station::GetByTile(tile);
-		TILE_AREA_LOOP(tile, st->airport) {
-			if (st->TileBelongsToAirport(tile)) FindVehicleOnPos(tile, &z, &FloodVehicleProc);
-		}
+		FindVehicleOnTileArea(st->airport, const_cast<Station *>(st), &FloodAirportVehicleProc);
 
 		/* No vehicle could be flooded on this airport anymore */
 		return;
@@ -1092,6 +1116,7 @@ void DoFloodTile(TileIndex target)
 	if (flooded) {
 		/* Mark surrounding canal tiles dirty too to avoid glitches */
 		MarkCanalsAndRiversAroundDirty(target);
+		YapfNotifyWaterLayoutChange(target);
 
 		/* update signals if needed */
 		UpdateSignalsInBuffer();